@@ -0,0 +1,257 @@
+// Бенчмарк PathFinder и полей потока на синтетической карте без окна и OpenGL.
+//
+// PathfindingBenchmark [размер карты] [число запросов] [seed]
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "engine/core/ThreadPool.hpp"
+#include "game/world/ChunkedTileMap.hpp"
+#include "game/world/FlowField.hpp"
+#include "game/world/PathFinder.hpp"
+#include "game/world/PathRequestQueue.hpp"
+#include "game/world/RegionMap.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    double millisecondsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Случайные озёра (круги воды) и стены с проходами поверх травы
+    void buildMap(game::ChunkedTileMap& map, int size, std::mt19937& rng) {
+        std::vector<std::uint8_t> water(static_cast<std::size_t>(size) * size, 0);
+        std::uniform_int_distribution<int> coord(0, size - 1);
+
+        for (int lake = 0; lake < size * size / 2500; ++lake) {
+            int cx = coord(rng), cy = coord(rng), radius = 3 + static_cast<int>(rng() % 18);
+            for (int y = std::max(0, cy - radius); y <= std::min(size - 1, cy + radius); ++y) {
+                for (int x = std::max(0, cx - radius); x <= std::min(size - 1, cx + radius); ++x) {
+                    if ((x - cx) * (x - cx) + (y - cy) * (y - cy) <= radius * radius) {
+                        water[static_cast<std::size_t>(y) * size + x] = 1;
+                    }
+                }
+            }
+        }
+        for (int wall = 0; wall < size / 8; ++wall) {
+            int x = coord(rng), y = coord(rng), length = 20 + static_cast<int>(rng() % 120);
+            bool horizontal = rng() % 2 == 0;
+            for (int i = 0; i < length; ++i) {
+                int wx = horizontal ? x + i : x, wy = horizontal ? y : y + i;
+                if (wx >= size || wy >= size) break;
+                if (i % 40 < 37) {
+                    water[static_cast<std::size_t>(wy) * size + wx] = 1;
+                }
+            }
+        }
+
+        const TileData ground(TileType::GROUND, true);
+        const TileData lakeWater(TileType::WATER, false);
+        map.reset(size, size);
+        const int chunks = (size + game::ChunkedTileMap::CHUNK_SIZE - 1) / game::ChunkedTileMap::CHUNK_SIZE;
+        for (int chunkY = 0; chunkY < chunks; ++chunkY) {
+            for (int chunkX = 0; chunkX < chunks; ++chunkX) {
+                auto chunk = game::ChunkedTileMap::makeChunk(chunkX, chunkY);
+                for (std::size_t index = 0; index < chunk->cells.getCellCount(); ++index) {
+                    GridPosition pos = chunk->cells.cellPosition(index);
+                    if (pos.x >= size || pos.y >= size) continue;
+                    bool isWater = water[static_cast<std::size_t>(pos.y) * size + pos.x] != 0;
+                    chunk->cells.setTile(index, isWater ? lakeWater : ground);
+                }
+                map.insertChunk(std::move(chunk));
+            }
+        }
+    }
+
+    struct QueryStats {
+        int found = 0;
+        double milliseconds = 0.0;
+        double length = 0.0;
+    };
+
+    QueryStats runQueries(game::PathFinder& pathFinder, const std::vector<GridPosition>& from,
+                          const std::vector<GridPosition>& to) {
+        QueryStats stats;
+        std::vector<GridPosition> path;
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < from.size(); ++i) {
+            if (pathFinder.findPath(from[i], to[i], path)) {
+                ++stats.found;
+                stats.length += game::PathFinder::pathLength(path);
+            }
+        }
+        stats.milliseconds = millisecondsSince(start);
+        return stats;
+    }
+
+    // Расчёт поля целиком, с ожиданием
+    std::shared_ptr<const game::FlowField> computeFlowField(game::FlowFieldCache& flowFields,
+                                                            const std::vector<GridPosition>& goals,
+                                                            std::size_t threads) {
+        auto start = Clock::now();
+        flowFields.request(goals);
+        flowFields.flush();
+        auto field = flowFields.request(goals);
+        std::cout << "Flow field (" << goals.size() << " goals, " << threads << " threads): "
+                  << field->getChunkCount() << " chunks, " << millisecondsSince(start) << " ms" << std::endl;
+        return field;
+    }
+
+    void report(const char* name, std::size_t queries, const QueryStats& stats) {
+        std::cout << name << ": " << queries << " queries, " << stats.found << " found, "
+                  << stats.milliseconds << " ms, "
+                  << (stats.milliseconds > 0.0 ? queries * 1000.0 / stats.milliseconds : 0.0) << " queries/s, "
+                  << "avg length " << (stats.found ? stats.length / stats.found : 0.0) << std::endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    const int size = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const int queries = argc > 2 ? std::atoi(argv[2]) : 10000;
+    const unsigned seed = argc > 3 ? static_cast<unsigned>(std::atoi(argv[3])) : 12345u;
+    if (size <= 0 || queries <= 0) {
+        std::cerr << "usage: PathfindingBenchmark [map size] [queries] [seed]" << std::endl;
+        return 1;
+    }
+
+    std::mt19937 rng(seed);
+    game::ChunkedTileMap map;
+    auto start = Clock::now();
+    buildMap(map, size, rng);
+    std::cout << "Map " << size << "x" << size << ": " << map.getChunkCount() << " chunks, "
+              << millisecondsSince(start) << " ms" << std::endl;
+
+    game::RegionMap regions;
+    game::PathFinder pathFinder(&regions);
+    start = Clock::now();
+    regions.update(map);
+    std::cout << "Regions: " << regions.getRegionCount() << ", " << millisecondsSince(start) << " ms" << std::endl;
+    start = Clock::now();
+    pathFinder.update(map);
+    std::cout << "Abstract graph: " << pathFinder.getNodeCount() << " nodes, "
+              << millisecondsSince(start) << " ms" << std::endl;
+
+    // Концы запросов - только проходимые клетки
+    std::uniform_int_distribution<int> coord(0, size - 1);
+    auto randomWalkable = [&](int x0, int y0, int x1, int y1) {
+        std::uniform_int_distribution<int> xs(std::max(0, x0), std::min(size - 1, x1));
+        std::uniform_int_distribution<int> ys(std::max(0, y0), std::min(size - 1, y1));
+        for (;;) {
+            GridPosition pos(xs(rng), ys(rng));
+            std::size_t index;
+            const game::TileChunk* chunk = map.findCell(pos, index);
+            if (chunk && chunk->cells.isWalkable(index)) return pos;
+        }
+    };
+
+    std::vector<GridPosition> from, to;
+    for (int i = 0; i < queries; ++i) {
+        GridPosition a = randomWalkable(0, 0, size - 1, size - 1);
+        from.push_back(a);
+        to.push_back(randomWalkable(a.x - 40, a.y - 40, a.x + 40, a.y + 40));
+    }
+    report("Short (<= 40 cells, JPS)", from.size(), runQueries(pathFinder, from, to));
+
+    from.clear();
+    to.clear();
+    for (int i = 0; i < queries; ++i) {
+        from.push_back(randomWalkable(0, 0, size - 1, size - 1));
+        to.push_back(randomWalkable(0, 0, size - 1, size - 1));
+    }
+    report("Long (anywhere, HPA*)", from.size(), runQueries(pathFinder, from, to));
+
+    engine::ThreadPool threadPool;
+    std::vector<GridPosition> goals;
+    for (int i = 0; i < 8; ++i) {
+        goals.push_back(randomWalkable(0, 0, size - 1, size - 1));
+    }
+
+    // Много агентов к нескольким целям через очередь: группы по цели,
+    // решаются в пуле потоков
+    {
+        game::PathRequestQueue requests(pathFinder, regions, threadPool);
+        std::vector<game::PathRequestQueue::Handle> handles;
+        start = Clock::now();
+        for (int i = 0; i < queries; ++i) {
+            handles.push_back(requests.request(from[i], goals[i % goals.size()]));
+        }
+        int frames = 0;
+        for (;;) {
+            requests.update();
+            ++frames;
+            bool ready = true;
+            for (const auto& handle : handles) {
+                if (!engine::isReady(handle)) {
+                    ready = false;
+                    break;
+                }
+            }
+            if (ready) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        double milliseconds = millisecondsSince(start);
+        int found = 0;
+        for (const auto& handle : handles) {
+            found += handle.get().found ? 1 : 0;
+        }
+        std::cout << "Queued (" << goals.size() << " goals, " << threadPool.getThreadCount() << " threads): "
+                  << queries << " requests, " << found << " found, " << milliseconds << " ms over "
+                  << frames << " updates, " << queries * 1000.0 / milliseconds << " requests/s" << std::endl;
+    }
+
+    // Те же агенты по одному полю потока к ближайшей из целей
+    game::FlowFieldCache flowFields(threadPool);
+    start = Clock::now();
+    flowFields.update(map);
+    std::cout << "Flow costs: " << millisecondsSince(start) << " ms" << std::endl;
+    auto flowField = computeFlowField(flowFields, goals, threadPool.getThreadCount());
+    start = Clock::now();
+    long long steps = 0;
+    int arrived = 0;
+    for (const GridPosition& agent : from) {
+        GridPosition pos = agent, step;
+        for (int i = 0; i < 4 * size && flowField->getDirection(pos, step); ++i) {
+            pos = GridPosition(pos.x + step.x, pos.y + step.y);
+            ++steps;
+        }
+        arrived += flowField->getCost(pos) == 0.0f ? 1 : 0;
+    }
+    double walkMilliseconds = millisecondsSince(start);
+    std::cout << "Flow walk: " << from.size() << " agents, " << arrived << " arrived, " << steps << " steps, "
+              << walkMilliseconds << " ms, " << (walkMilliseconds > 0.0 ? steps / walkMilliseconds / 1000.0 : 0.0)
+              << " Msteps/s" << std::endl;
+
+    // Правка одного чанка пересчитывает только его и соседей
+    const int edits = 100;
+    double editMilliseconds = 0.0;
+    for (int i = 0; i < edits; ++i) {
+        GridPosition center(coord(rng), coord(rng));
+        std::size_t index;
+        game::TileChunk* chunk = map.findCell(center, index);
+        if (!chunk) continue;
+        for (std::size_t cell = 0; cell < chunk->cells.getCellCount(); cell += 7) {
+            bool blocked = rng() % 3 == 0;
+            chunk->cells.typeData()[cell] = blocked ? TileType::WATER : TileType::GROUND;
+            chunk->cells.walkableData()[cell] = blocked ? 0 : 1;
+            chunk->bits.updateCell(chunk->cells, cell);
+        }
+        chunk->cells.markChanged();
+
+        start = Clock::now();
+        regions.update(map);
+        pathFinder.update(map);
+        editMilliseconds += millisecondsSince(start);
+    }
+    std::cout << "Chunk edit + update: " << editMilliseconds / edits << " ms average" << std::endl;
+    report("Long after edits", from.size(), runQueries(pathFinder, from, to));
+    start = Clock::now();
+    flowFields.update(map);
+    std::cout << "Flow costs after edits: " << millisecondsSince(start) << " ms" << std::endl;
+    computeFlowField(flowFields, goals, threadPool.getThreadCount());
+    return 0;
+}
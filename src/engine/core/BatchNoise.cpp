@@ -0,0 +1,351 @@
+#include "BatchNoise.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BATCH_NOISE_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BATCH_NOISE_AVX2
+#else
+#define BATCH_NOISE_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace engine {
+
+namespace {
+    // Константы SinglePerlin из FastNoiseLite; вся целочисленная арифметика -
+    // в uint32, переполнение там то же, что у int в оригинале
+    constexpr std::uint32_t PRIME_X = 501125321u;
+    constexpr std::uint32_t PRIME_Y = 1136930381u;
+    constexpr std::uint32_t HASH_MULTIPLIER = 0x27d4eb2du;
+    constexpr std::uint32_t GRADIENT_MASK = 127u << 1;
+    constexpr float PERLIN_SCALE = 1.4247691104677813f;
+
+    // FastNoiseLite::Lookup<float>::Gradients2D - в заголовке она закрыта
+    alignas(32) const float GRADIENTS[256] = {
+        0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+        0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+        0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+        -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+        -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+        -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+        0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+        0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+        0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+        -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+        -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+        -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+        0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+        0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+        0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+        -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+        -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+        -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+        0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+        0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+        0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+        -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+        -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+        -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+        0.130526192220052f, 0.99144486137381f, 0.38268343236509f, 0.923879532511287f, 0.608761429008721f, 0.793353340291235f, 0.793353340291235f, 0.608761429008721f,
+        0.923879532511287f, 0.38268343236509f, 0.99144486137381f, 0.130526192220051f, 0.99144486137381f, -0.130526192220051f, 0.923879532511287f, -0.38268343236509f,
+        0.793353340291235f, -0.60876142900872f, 0.608761429008721f, -0.793353340291235f, 0.38268343236509f, -0.923879532511287f, 0.130526192220052f, -0.99144486137381f,
+        -0.130526192220052f, -0.99144486137381f, -0.38268343236509f, -0.923879532511287f, -0.608761429008721f, -0.793353340291235f, -0.793353340291235f, -0.608761429008721f,
+        -0.923879532511287f, -0.38268343236509f, -0.99144486137381f, -0.130526192220052f, -0.99144486137381f, 0.130526192220051f, -0.923879532511287f, 0.38268343236509f,
+        -0.793353340291235f, 0.608761429008721f, -0.608761429008721f, 0.793353340291235f, -0.38268343236509f, 0.923879532511287f, -0.130526192220052f, 0.99144486137381f,
+        0.38268343236509f, 0.923879532511287f, 0.923879532511287f, 0.38268343236509f, 0.923879532511287f, -0.38268343236509f, 0.38268343236509f, -0.923879532511287f,
+        -0.38268343236509f, -0.923879532511287f, -0.923879532511287f, -0.38268343236509f, -0.923879532511287f, 0.38268343236509f, -0.38268343236509f, 0.923879532511287f
+    };
+
+    // Всё, что в октаве зависит только от y: общее для строки
+    struct OctaveRow {
+        float scale;
+        float amplitude;
+        float yd0;
+        float yd1;
+        float ys;
+        std::uint32_t y0;
+        std::uint32_t y1;
+    };
+
+    using OctaveRows = std::array<OctaveRow, BatchNoise::MAX_OCTAVES>;
+
+    int fastFloor(float f) {
+        return f >= 0 ? static_cast<int>(f) : static_cast<int>(f) - 1;
+    }
+
+    float interpQuintic(float t) {
+        return t * t * t * (t * (t * 6 - 15) + 10);
+    }
+
+    float lerp(float a, float b, float t) {
+        return a + t * (b - a);
+    }
+
+    void prepareRows(float frequency, int octaves, int y, OctaveRows& rows) {
+        float scale = 1.0f;
+        float amplitude = 1.0f;
+        for (int octave = 0; octave < octaves; ++octave) {
+            OctaveRow& row = rows[octave];
+            float yf = y * scale * frequency;
+            int y0 = fastFloor(yf);
+            row.scale = scale;
+            row.amplitude = amplitude;
+            row.yd0 = yf - y0;
+            row.yd1 = row.yd0 - 1;
+            row.ys = interpQuintic(row.yd0);
+            row.y0 = static_cast<std::uint32_t>(y0) * PRIME_Y;
+            row.y1 = row.y0 + PRIME_Y;
+            amplitude *= 0.5f;
+            scale *= 2.0f;
+        }
+    }
+
+    float gradient(std::uint32_t seed, std::uint32_t xPrimed, std::uint32_t yPrimed, float xd, float yd) {
+        std::uint32_t hash = (seed ^ xPrimed ^ yPrimed) * HASH_MULTIPLIER;
+        hash ^= hash >> 15;
+        hash &= GRADIENT_MASK;
+        return xd * GRADIENTS[hash] + yd * GRADIENTS[hash | 1];
+    }
+
+    void fillRowScalar(std::uint32_t seed, float frequency, const OctaveRows& rows, int octaves,
+                       int x, int count, float* out) {
+        for (int i = 0; i < count; ++i) {
+            float value = 0.0f;
+            for (int octave = 0; octave < octaves; ++octave) {
+                const OctaveRow& row = rows[octave];
+                float xf = (x + i) * row.scale * frequency;
+                int x0 = fastFloor(xf);
+                float xd0 = xf - x0;
+                float xd1 = xd0 - 1;
+                float xs = interpQuintic(xd0);
+                std::uint32_t x0Primed = static_cast<std::uint32_t>(x0) * PRIME_X;
+                std::uint32_t x1Primed = x0Primed + PRIME_X;
+
+                float xf0 = lerp(gradient(seed, x0Primed, row.y0, xd0, row.yd0),
+                                 gradient(seed, x1Primed, row.y0, xd1, row.yd0), xs);
+                float xf1 = lerp(gradient(seed, x0Primed, row.y1, xd0, row.yd1),
+                                 gradient(seed, x1Primed, row.y1, xd1, row.yd1), xs);
+                value += lerp(xf0, xf1, row.ys) * PERLIN_SCALE * row.amplitude;
+            }
+            out[i] = value;
+        }
+    }
+
+#ifdef BATCH_NOISE_X86
+    // Операции в том же порядке, что и в скалярном пути, без FMA - поэтому
+    // результат от ширины не зависит
+
+    __m128i mulLoSse2(__m128i a, __m128i b) {
+        __m128i even = _mm_mul_epu32(a, b);
+        __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+    }
+
+    __m128 interpQuinticSse2(__m128 t) {
+        __m128 inner = _mm_add_ps(_mm_mul_ps(t, _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6.0f)), _mm_set1_ps(15.0f))),
+                                  _mm_set1_ps(10.0f));
+        return _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(t, t), t), inner);
+    }
+
+    __m128 lerpSse2(__m128 a, __m128 b, __m128 t) {
+        return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+    }
+
+    __m128 gradientSse2(__m128i seed, __m128i xPrimed, __m128i yPrimed, __m128 xd, __m128 yd) {
+        __m128i hash = mulLoSse2(_mm_xor_si128(_mm_xor_si128(seed, xPrimed), yPrimed),
+                                 _mm_set1_epi32(static_cast<int>(HASH_MULTIPLIER)));
+        hash = _mm_xor_si128(hash, _mm_srli_epi32(hash, 15));
+        hash = _mm_and_si128(hash, _mm_set1_epi32(static_cast<int>(GRADIENT_MASK)));
+
+        // В SSE2 нет gather - индексы достаются через память
+        alignas(16) std::uint32_t index[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(index), hash);
+        __m128 xg = _mm_setr_ps(GRADIENTS[index[0]], GRADIENTS[index[1]], GRADIENTS[index[2]], GRADIENTS[index[3]]);
+        __m128 yg = _mm_setr_ps(GRADIENTS[index[0] | 1], GRADIENTS[index[1] | 1],
+                                GRADIENTS[index[2] | 1], GRADIENTS[index[3] | 1]);
+        return _mm_add_ps(_mm_mul_ps(xd, xg), _mm_mul_ps(yd, yg));
+    }
+
+    void fillRowSse2(std::uint32_t seed, float frequency, const OctaveRows& rows, int octaves,
+                     int x, int count, float* out) {
+        const __m128i seedLanes = _mm_set1_epi32(static_cast<int>(seed));
+        const __m128i primeX = _mm_set1_epi32(static_cast<int>(PRIME_X));
+        const __m128 frequencyLanes = _mm_set1_ps(frequency);
+        const __m128 one = _mm_set1_ps(1.0f);
+        for (int i = 0; i < count; i += 4) {
+            const __m128 cell = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x + i), _mm_setr_epi32(0, 1, 2, 3)));
+            __m128 value = _mm_setzero_ps();
+            for (int octave = 0; octave < octaves; ++octave) {
+                const OctaveRow& row = rows[octave];
+                __m128 xf = _mm_mul_ps(_mm_mul_ps(cell, _mm_set1_ps(row.scale)), frequencyLanes);
+                // fastFloor: усечение, у отрицательных ещё -1 (маска сравнения равна -1)
+                __m128i x0 = _mm_add_epi32(_mm_cvttps_epi32(xf),
+                                           _mm_castps_si128(_mm_cmplt_ps(xf, _mm_setzero_ps())));
+                __m128 xd0 = _mm_sub_ps(xf, _mm_cvtepi32_ps(x0));
+                __m128 xd1 = _mm_sub_ps(xd0, one);
+                __m128 xs = interpQuinticSse2(xd0);
+                __m128i x0Primed = mulLoSse2(x0, primeX);
+                __m128i x1Primed = _mm_add_epi32(x0Primed, primeX);
+
+                __m128i y0 = _mm_set1_epi32(static_cast<int>(row.y0));
+                __m128i y1 = _mm_set1_epi32(static_cast<int>(row.y1));
+                __m128 yd0 = _mm_set1_ps(row.yd0);
+                __m128 yd1 = _mm_set1_ps(row.yd1);
+                __m128 xf0 = lerpSse2(gradientSse2(seedLanes, x0Primed, y0, xd0, yd0),
+                                      gradientSse2(seedLanes, x1Primed, y0, xd1, yd0), xs);
+                __m128 xf1 = lerpSse2(gradientSse2(seedLanes, x0Primed, y1, xd0, yd1),
+                                      gradientSse2(seedLanes, x1Primed, y1, xd1, yd1), xs);
+                __m128 noise = _mm_mul_ps(lerpSse2(xf0, xf1, _mm_set1_ps(row.ys)), _mm_set1_ps(PERLIN_SCALE));
+                value = _mm_add_ps(value, _mm_mul_ps(noise, _mm_set1_ps(row.amplitude)));
+            }
+            if (count - i >= 4) {
+                _mm_storeu_ps(out + i, value);
+            } else {
+                alignas(16) float tail[4];
+                _mm_store_ps(tail, value);
+                std::copy(tail, tail + (count - i), out + i);
+            }
+        }
+    }
+
+    BATCH_NOISE_AVX2 __m256 interpQuinticAvx2(__m256 t) {
+        __m256 inner = _mm256_add_ps(
+            _mm256_mul_ps(t, _mm256_sub_ps(_mm256_mul_ps(t, _mm256_set1_ps(6.0f)), _mm256_set1_ps(15.0f))),
+            _mm256_set1_ps(10.0f));
+        return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), inner);
+    }
+
+    BATCH_NOISE_AVX2 __m256 lerpAvx2(__m256 a, __m256 b, __m256 t) {
+        return _mm256_add_ps(a, _mm256_mul_ps(t, _mm256_sub_ps(b, a)));
+    }
+
+    BATCH_NOISE_AVX2 __m256 gradientAvx2(__m256i seed, __m256i xPrimed, __m256i yPrimed, __m256 xd, __m256 yd) {
+        __m256i hash = _mm256_mullo_epi32(_mm256_xor_si256(_mm256_xor_si256(seed, xPrimed), yPrimed),
+                                          _mm256_set1_epi32(static_cast<int>(HASH_MULTIPLIER)));
+        hash = _mm256_xor_si256(hash, _mm256_srli_epi32(hash, 15));
+        hash = _mm256_and_si256(hash, _mm256_set1_epi32(static_cast<int>(GRADIENT_MASK)));
+        __m256 xg = _mm256_i32gather_ps(GRADIENTS, hash, 4);
+        __m256 yg = _mm256_i32gather_ps(GRADIENTS + 1, hash, 4);
+        return _mm256_add_ps(_mm256_mul_ps(xd, xg), _mm256_mul_ps(yd, yg));
+    }
+
+    BATCH_NOISE_AVX2 void fillRowAvx2(std::uint32_t seed, float frequency, const OctaveRows& rows, int octaves,
+                                      int x, int count, float* out) {
+        const __m256i seedLanes = _mm256_set1_epi32(static_cast<int>(seed));
+        const __m256i primeX = _mm256_set1_epi32(static_cast<int>(PRIME_X));
+        const __m256 frequencyLanes = _mm256_set1_ps(frequency);
+        const __m256 one = _mm256_set1_ps(1.0f);
+        for (int i = 0; i < count; i += 8) {
+            const __m256 cell = _mm256_cvtepi32_ps(
+                _mm256_add_epi32(_mm256_set1_epi32(x + i), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+            __m256 value = _mm256_setzero_ps();
+            for (int octave = 0; octave < octaves; ++octave) {
+                const OctaveRow& row = rows[octave];
+                __m256 xf = _mm256_mul_ps(_mm256_mul_ps(cell, _mm256_set1_ps(row.scale)), frequencyLanes);
+                __m256i x0 = _mm256_add_epi32(_mm256_cvttps_epi32(xf),
+                                              _mm256_castps_si256(_mm256_cmp_ps(xf, _mm256_setzero_ps(), _CMP_LT_OQ)));
+                __m256 xd0 = _mm256_sub_ps(xf, _mm256_cvtepi32_ps(x0));
+                __m256 xd1 = _mm256_sub_ps(xd0, one);
+                __m256 xs = interpQuinticAvx2(xd0);
+                __m256i x0Primed = _mm256_mullo_epi32(x0, primeX);
+                __m256i x1Primed = _mm256_add_epi32(x0Primed, primeX);
+
+                __m256i y0 = _mm256_set1_epi32(static_cast<int>(row.y0));
+                __m256i y1 = _mm256_set1_epi32(static_cast<int>(row.y1));
+                __m256 yd0 = _mm256_set1_ps(row.yd0);
+                __m256 yd1 = _mm256_set1_ps(row.yd1);
+                __m256 xf0 = lerpAvx2(gradientAvx2(seedLanes, x0Primed, y0, xd0, yd0),
+                                      gradientAvx2(seedLanes, x1Primed, y0, xd1, yd0), xs);
+                __m256 xf1 = lerpAvx2(gradientAvx2(seedLanes, x0Primed, y1, xd0, yd1),
+                                      gradientAvx2(seedLanes, x1Primed, y1, xd1, yd1), xs);
+                __m256 noise = _mm256_mul_ps(lerpAvx2(xf0, xf1, _mm256_set1_ps(row.ys)), _mm256_set1_ps(PERLIN_SCALE));
+                value = _mm256_add_ps(value, _mm256_mul_ps(noise, _mm256_set1_ps(row.amplitude)));
+            }
+            if (count - i >= 8) {
+                _mm256_storeu_ps(out + i, value);
+            } else {
+                alignas(32) float tail[8];
+                _mm256_store_ps(tail, value);
+                std::copy(tail, tail + (count - i), out + i);
+            }
+        }
+    }
+
+    bool cpuHasAvx2() {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) return false;
+        // AVX2 нужна и поддержка ОС: OSXSAVE и сохранение регистров YMM
+        __cpuid(info, 1);
+        if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+        if ((_xgetbv(0) & 6) != 6) return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+#endif
+
+    enum class InstructionSet { Scalar, Sse2, Avx2 };
+
+    InstructionSet detectInstructionSet() {
+#ifdef BATCH_NOISE_X86
+        return cpuHasAvx2() ? InstructionSet::Avx2 : InstructionSet::Sse2;
+#else
+        return InstructionSet::Scalar;
+#endif
+    }
+
+    InstructionSet instructionSet() {
+        static const InstructionSet detected = detectInstructionSet();
+        return detected;
+    }
+}
+
+BatchNoise::BatchNoise(int seed, float frequency, int octaves)
+    : seed(seed), frequency(frequency), octaves(std::clamp(octaves, 1, MAX_OCTAVES)) {
+}
+
+void BatchNoise::fillRow(int x, int y, int count, float* out) const {
+    if (count <= 0) return;
+    OctaveRows rows;
+    prepareRows(frequency, octaves, y, rows);
+    const std::uint32_t hashSeed = static_cast<std::uint32_t>(seed);
+    switch (instructionSet()) {
+#ifdef BATCH_NOISE_X86
+        case InstructionSet::Avx2:
+            fillRowAvx2(hashSeed, frequency, rows, octaves, x, count, out);
+            break;
+        case InstructionSet::Sse2:
+            fillRowSse2(hashSeed, frequency, rows, octaves, x, count, out);
+            break;
+#endif
+        default:
+            fillRowScalar(hashSeed, frequency, rows, octaves, x, count, out);
+            break;
+    }
+}
+
+void BatchNoise::fillRect(int x, int y, int width, int height, float* out, std::size_t stride) const {
+    for (int row = 0; row < height; ++row) {
+        fillRow(x, y + row, width, out + static_cast<std::size_t>(row) * stride);
+    }
+}
+
+const char* BatchNoise::getInstructionSet() {
+    switch (instructionSet()) {
+        case InstructionSet::Avx2: return "AVX2";
+        case InstructionSet::Sse2: return "SSE2";
+        default: return "scalar";
+    }
+}
+
+} // namespace engine
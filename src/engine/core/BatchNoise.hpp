@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+namespace engine {
+
+    // Шум Perlin из FastNoiseLite (NoiseType_Perlin, без встроенного фрактала),
+    // посчитанный сразу для строк клеток с целыми координатами.
+    // На x86-64 строка идёт по 8 клеток (AVX2) или по 4 (SSE2) - набор
+    // инструкций выбирается один раз при первом вызове; иначе скалярный путь.
+    //
+    // Октавы складываются так же, как в генераторах карт: один сид, частота
+    // каждой следующей x2, амплитуда x0.5. Значения совпадают с суммой
+    // FastNoiseLite::GetNoise(x * freq, y * freq) * amp с точностью до
+    // округления float (побитово, если компилятор не сливает умножение со
+    // сложением в FMA).
+    class BatchNoise {
+    public:
+        static constexpr int MAX_OCTAVES = 16;
+
+        BatchNoise(int seed, float frequency, int octaves = 1);
+
+        // out[i] - шум в клетке (x + i, y), i < count
+        void fillRow(int x, int y, int count, float* out) const;
+
+        // Прямоугольник width x height с углом в (x, y): строка row пишется
+        // с out + row * stride
+        void fillRect(int x, int y, int width, int height, float* out, std::size_t stride) const;
+
+        int getSeed() const { return seed; }
+        float getFrequency() const { return frequency; }
+        int getOctaves() const { return octaves; }
+
+        // "AVX2", "SSE2" или "scalar"
+        static const char* getInstructionSet();
+
+    private:
+        int seed;
+        float frequency;
+        int octaves;
+    };
+
+} // namespace engine
@@ -0,0 +1,51 @@
+#include "ChunkArena.hpp"
+#include <cstdint>
+#include <new>
+
+namespace engine {
+
+    ChunkArena::ChunkArena(std::size_t chunkSize)
+        : chunkSize(chunkSize) {
+    }
+
+    ChunkArena::~ChunkArena() {
+        release();
+    }
+
+    void* ChunkArena::allocate(std::size_t size, std::size_t alignment) {
+        if (!chunks.empty()) {
+            Chunk& chunk = chunks.back();
+            auto base = reinterpret_cast<std::uintptr_t>(chunk.data);
+            std::uintptr_t aligned = (base + offset + alignment - 1) & ~(std::uintptr_t(alignment) - 1);
+            std::size_t newOffset = static_cast<std::size_t>(aligned - base) + size;
+            if (newOffset <= chunk.size) {
+                offset = newOffset;
+                return reinterpret_cast<void*>(aligned);
+            }
+        }
+
+        // Не хватило места - заводим новый чанк (крупные запросы получают свой чанк)
+        std::size_t paddedSize = size + alignment;
+        std::size_t newChunkSize = paddedSize > chunkSize ? paddedSize : chunkSize;
+        chunks.push_back({static_cast<std::byte*>(::operator new(newChunkSize)), newChunkSize});
+        offset = 0;
+        return allocate(size, alignment);
+    }
+
+    void ChunkArena::release() {
+        for (auto& chunk : chunks) {
+            ::operator delete(chunk.data);
+        }
+        chunks.clear();
+        offset = 0;
+    }
+
+    std::size_t ChunkArena::getBytesReserved() const {
+        std::size_t total = 0;
+        for (const auto& chunk : chunks) {
+            total += chunk.size;
+        }
+        return total;
+    }
+
+} // namespace engine
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace engine {
+
+    // Линейный (bump) аллокатор поверх крупных чанков фиксированного размера.
+    // Отдельные выделения не освобождаются: вся память отдается разом при
+    // уничтожении арены - по одному free на чанк, сколько бы объектов в нем ни было.
+    // Деструкторы объектов вызывает владелец памяти.
+    class ChunkArena {
+    public:
+        static constexpr std::size_t DEFAULT_CHUNK_SIZE = 4 * 1024 * 1024;
+
+        explicit ChunkArena(std::size_t chunkSize = DEFAULT_CHUNK_SIZE);
+        ~ChunkArena();
+
+        // Запрещаем копирование
+        ChunkArena(const ChunkArena&) = delete;
+        ChunkArena& operator=(const ChunkArena&) = delete;
+
+        void* allocate(std::size_t size, std::size_t alignment);
+
+        template<typename T>
+        T* allocateArray(std::size_t count) {
+            return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        // Освобождает все чанки разом
+        void release();
+
+        std::size_t getChunkCount() const { return chunks.size(); }
+        std::size_t getBytesReserved() const;
+
+    private:
+        struct Chunk {
+            std::byte* data;
+            std::size_t size;
+        };
+
+        std::vector<Chunk> chunks;
+        std::size_t chunkSize;
+        std::size_t offset = 0;  // Смещение внутри последнего чанка
+    };
+
+} // namespace engine
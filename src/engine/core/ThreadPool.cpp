@@ -0,0 +1,57 @@
+#include "ThreadPool.hpp"
+
+namespace engine {
+
+    ThreadPool::ThreadPool(std::size_t threadCount) {
+        if (threadCount == 0) {
+            threadCount = 1;
+        }
+        workers.reserve(threadCount);
+        for (std::size_t i = 0; i < threadCount; ++i) {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    std::size_t ThreadPool::defaultThreadCount() {
+        // Один поток оставляем главному циклу (рендеринг, UI)
+        unsigned int hardware = std::thread::hardware_concurrency();
+        return hardware > 1 ? hardware - 1 : 1;
+    }
+
+    void ThreadPool::enqueue(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push(std::move(task));
+        }
+        condition.notify_one();
+    }
+
+    void ThreadPool::workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                // Перед остановкой дорабатываем оставшиеся задачи
+                if (stopping && tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+} // namespace engine
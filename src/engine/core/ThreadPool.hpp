@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace engine {
+
+    // Фиксированный пул рабочих потоков с общей очередью задач.
+    // Задача, выполняющаяся в пуле, не должна блокироваться в ожидании
+    // другой задачи этого же пула - иначе при занятых потоках возможна взаимоблокировка.
+    class ThreadPool {
+    public:
+        explicit ThreadPool(std::size_t threadCount = defaultThreadCount());
+        ~ThreadPool();
+
+        // Запрещаем копирование
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template<typename Func>
+        auto submit(Func&& fn) -> std::future<std::invoke_result_t<std::decay_t<Func>>> {
+            using Result = std::invoke_result_t<std::decay_t<Func>>;
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Func>(fn));
+            std::future<Result> result = task->get_future();
+            enqueue([task]() { (*task)(); });
+            return result;
+        }
+
+        std::size_t getThreadCount() const { return workers.size(); }
+
+        static std::size_t defaultThreadCount();
+
+    private:
+        std::vector<std::thread> workers;
+        std::queue<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool stopping = false;
+
+        void enqueue(std::function<void()> task);
+        void workerLoop();
+    };
+
+    // Готов ли результат future/shared_future, без ожидания
+    template<typename Future>
+    bool isReady(const Future& future) {
+        return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+} // namespace engine
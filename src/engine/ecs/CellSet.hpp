@@ -0,0 +1,185 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <vector>
+#include "../../game/Tile.hpp"
+
+namespace engine {
+    // Set of grid cells stored as sorted, non-overlapping row spans [x0, x1).
+    // A WxH rectangle costs H spans regardless of W, and set operations walk
+    // spans rather than cells, so comparing two selections is proportional to
+    // their outlines plus the cells that actually differ, not to the map size.
+    class CellSet {
+    public:
+        struct Span {
+            int y;
+            int x0;
+            int x1;
+        };
+
+        static CellSet cell(const GridPosition& pos) {
+            CellSet set;
+            set.addSpan(pos.y, pos.x, pos.x + 1);
+            return set;
+        }
+
+        // Corners are inclusive and may be given in any order
+        static CellSet rectangle(const GridPosition& a, const GridPosition& b) {
+            CellSet set;
+            int x0 = std::min(a.x, b.x), x1 = std::max(a.x, b.x) + 1;
+            for (int y = std::min(a.y, b.y), yEnd = std::max(a.y, b.y); y <= yEnd; ++y) {
+                set.addSpan(y, x0, x1);
+            }
+            return set;
+        }
+
+        // Cells whose centers lie within `radius` of the center cell's center
+        static CellSet circle(const GridPosition& center, int radius) {
+            CellSet set;
+            radius = std::max(radius, 0);
+            for (int dy = -radius; dy <= radius; ++dy) {
+                int dx = 0;
+                while ((dx + 1) * (dx + 1) + dy * dy <= radius * radius) {
+                    ++dx;
+                }
+                set.addSpan(center.y + dy, center.x - dx, center.x + dx + 1);
+            }
+            return set;
+        }
+
+        // Bresenham line between a and b (both included); built row by row, so
+        // a line of length L costs O(L) and at most L spans
+        static CellSet line(GridPosition a, GridPosition b) {
+            CellSet set;
+            if (a.y > b.y || (a.y == b.y && a.x > b.x)) {
+                std::swap(a, b);
+            }
+            int dx = std::abs(b.x - a.x), dy = b.y - a.y;
+            int stepX = a.x < b.x ? 1 : -1;
+            int error = dx - dy;
+            int x = a.x, y = a.y, rowMin = x, rowMax = x;
+            while (x != b.x || y != b.y) {
+                int doubled = 2 * error;
+                if (doubled > -dy) {
+                    error -= dy;
+                    x += stepX;
+                }
+                if (doubled < dx) {
+                    error += dx;
+                    set.addSpan(y, rowMin, rowMax + 1);
+                    ++y;
+                    rowMin = rowMax = x;
+                } else {
+                    rowMin = std::min(rowMin, x);
+                    rowMax = std::max(rowMax, x);
+                }
+            }
+            set.addSpan(y, rowMin, rowMax + 1);
+            return set;
+        }
+
+        // Appending in (y, x) order is O(1); anything else falls back to a merge
+        void addSpan(int y, int x0, int x1) {
+            if (x0 >= x1) return;
+            if (spans.empty() || y > spans.back().y ||
+                (y == spans.back().y && x0 > spans.back().x1)) {
+                spans.push_back({y, x0, x1});
+            } else if (y == spans.back().y && x0 >= spans.back().x0) {
+                spans.back().x1 = std::max(spans.back().x1, x1);
+            } else {
+                CellSet single;
+                single.spans.push_back({y, x0, x1});
+                unite(single);
+            }
+        }
+
+        void unite(const CellSet& other) {
+            if (other.empty()) return;
+            std::vector<Span> merged;
+            merged.reserve(spans.size() + other.spans.size());
+            std::merge(spans.begin(), spans.end(), other.spans.begin(), other.spans.end(),
+                       std::back_inserter(merged), [](const Span& a, const Span& b) {
+                return a.y < b.y || (a.y == b.y && a.x0 < b.x0);
+            });
+            spans.clear();
+            for (const Span& span : merged) {
+                if (!spans.empty() && spans.back().y == span.y && span.x0 <= spans.back().x1) {
+                    spans.back().x1 = std::max(spans.back().x1, span.x1);
+                } else {
+                    spans.push_back(span);
+                }
+            }
+        }
+
+        bool contains(const GridPosition& pos) const {
+            auto it = std::upper_bound(spans.begin(), spans.end(), pos, [](const GridPosition& p, const Span& span) {
+                return p.y < span.y || (p.y == span.y && p.x < span.x0);
+            });
+            if (it == spans.begin()) return false;
+            --it;
+            return it->y == pos.y && pos.x < it->x1;
+        }
+
+        // Number of cells
+        std::size_t size() const {
+            std::size_t count = 0;
+            for (const Span& span : spans) {
+                count += static_cast<std::size_t>(span.x1 - span.x0);
+            }
+            return count;
+        }
+
+        bool empty() const { return spans.empty(); }
+        void clear() { spans.clear(); }
+        const std::vector<Span>& getSpans() const { return spans; }
+
+        template<typename Func>
+        void forEach(Func&& fn) const {
+            for (const Span& span : spans) {
+                for (int x = span.x0; x < span.x1; ++x) {
+                    fn(GridPosition(x, span.y));
+                }
+            }
+        }
+
+        // fn(GridPosition) for every cell inside [x0, x1) x [y0, y1)
+        template<typename Func>
+        void forEachInRect(int x0, int y0, int x1, int y1, Func&& fn) const {
+            auto it = std::lower_bound(spans.begin(), spans.end(), y0, [](const Span& span, int y) {
+                return span.y < y;
+            });
+            for (; it != spans.end() && it->y < y1; ++it) {
+                for (int x = std::max(it->x0, x0), end = std::min(it->x1, x1); x < end; ++x) {
+                    fn(GridPosition(x, it->y));
+                }
+            }
+        }
+
+        // fn(GridPosition) for every cell of a that is not in b
+        template<typename Func>
+        static void forEachDifference(const CellSet& a, const CellSet& b, Func&& fn) {
+            std::size_t j = 0;
+            for (const Span& span : a.spans) {
+                while (j < b.spans.size() && (b.spans[j].y < span.y ||
+                       (b.spans[j].y == span.y && b.spans[j].x1 <= span.x0))) {
+                    ++j;
+                }
+                int x = span.x0;
+                for (std::size_t k = j; k < b.spans.size() && b.spans[k].y == span.y && b.spans[k].x0 < span.x1; ++k) {
+                    for (; x < b.spans[k].x0; ++x) {
+                        fn(GridPosition(x, span.y));
+                    }
+                    x = std::max(x, b.spans[k].x1);
+                }
+                for (; x < span.x1; ++x) {
+                    fn(GridPosition(x, span.y));
+                }
+            }
+        }
+
+    private:
+        std::vector<Span> spans;
+    };
+}
@@ -0,0 +1,141 @@
+#pragma once
+#include <memory>
+#include <utility>
+#include <vector>
+#include "World.hpp"
+
+namespace engine {
+    // Records structural changes (create/destroy entities, add/remove components)
+    // so they can be made while World is being iterated, or from several threads
+    // at once with one buffer per thread, and applied later at a sync point.
+    //
+    // playback() applies commands grouped by kind and then by component type,
+    // in ComponentTypeID order, so each pool is touched in one run:
+    //   creates -> adds (per type) -> removes (per type) -> destroys.
+    // Within one type, commands keep their recording order.
+    class CommandBuffer {
+    public:
+        CommandBuffer() = default;
+        CommandBuffer(CommandBuffer&&) = default;
+        CommandBuffer& operator=(CommandBuffer&&) = default;
+
+        // Returns a placeholder that can be passed to addComponent/removeComponent/
+        // destroyEntity of this buffer; the real entity exists after playback.
+        EntityID createEntity() {
+            return makeEntityID(createCount++, ENTITY_RESERVED_GENERATION);
+        }
+
+        void destroyEntity(EntityID id) {
+            destroys.push_back(id);
+        }
+
+        template<typename T, typename... Args>
+        void addComponent(EntityID id, Args&&... args) {
+            getQueue<T>().adds.emplace_back(id, T(std::forward<Args>(args)...));
+        }
+
+        template<typename T>
+        void removeComponent(EntityID id) {
+            getQueue<T>().removes.push_back(id);
+        }
+
+        bool empty() const {
+            if (createCount != 0 || !destroys.empty()) return false;
+            for (const auto& queue : queues) {
+                if (queue && !queue->empty()) return false;
+            }
+            return true;
+        }
+
+        void clear() {
+            createCount = 0;
+            destroys.clear();
+            for (auto& queue : queues) {
+                if (queue) queue->clear();
+            }
+        }
+
+        // Applies and clears all recorded commands. Queues keep their capacity,
+        // so a buffer reused every frame stops allocating after warm-up.
+        void playback(World& world) {
+            created.clear();
+            world.reserveEntities(createCount);
+            for (std::uint32_t i = 0; i < createCount; ++i) {
+                created.push_back(world.createEntity()->getID());
+            }
+
+            for (auto& queue : queues) {
+                if (queue) queue->applyAdds(world, *this);
+            }
+            for (auto& queue : queues) {
+                if (queue) queue->applyRemoves(world, *this);
+            }
+            for (EntityID id : destroys) {
+                world.destroyEntity(resolve(id));
+            }
+            clear();
+        }
+
+        // Maps a placeholder from createEntity() to the real ID during playback;
+        // real IDs pass through unchanged
+        EntityID resolve(EntityID id) const {
+            if (entityGeneration(id) != ENTITY_RESERVED_GENERATION) return id;
+            std::uint32_t index = entityIndex(id);
+            return index < created.size() ? created[index] : NULL_ENTITY;
+        }
+
+    private:
+        struct Queue {
+            virtual ~Queue() = default;
+            virtual void applyAdds(World& world, const CommandBuffer& buffer) = 0;
+            virtual void applyRemoves(World& world, const CommandBuffer& buffer) = 0;
+            virtual bool empty() const = 0;
+            virtual void clear() = 0;
+        };
+
+        template<typename T>
+        struct TypedQueue : Queue {
+            std::vector<std::pair<EntityID, T>> adds;
+            std::vector<EntityID> removes;
+
+            void applyAdds(World& world, const CommandBuffer& buffer) override {
+                if (adds.empty()) return;
+                world.reserve<T>(adds.size());
+                for (auto& [id, component] : adds) {
+                    world.addComponent<T>(buffer.resolve(id), std::move(component));
+                }
+            }
+
+            void applyRemoves(World& world, const CommandBuffer& buffer) override {
+                for (EntityID id : removes) {
+                    world.removeComponent<T>(buffer.resolve(id));
+                }
+            }
+
+            bool empty() const override { return adds.empty() && removes.empty(); }
+
+            void clear() override {
+                adds.clear();
+                removes.clear();
+            }
+        };
+
+        std::uint32_t createCount = 0;
+        std::vector<EntityID> created;
+        std::vector<EntityID> destroys;
+        // Indexed by ComponentTypeID, which is what orders playback by type
+        std::vector<std::unique_ptr<Queue>> queues;
+
+        template<typename T>
+        TypedQueue<T>& getQueue() {
+            ComponentTypeID type = getComponentTypeID<T>();
+            if (type >= queues.size()) {
+                queues.resize(static_cast<std::size_t>(type) + 1);
+            }
+            if (!queues[type]) {
+                queues[type] = std::make_unique<TypedQueue<T>>();
+            }
+            return static_cast<TypedQueue<T>&>(*queues[type]);
+        }
+    };
+}
@@ -2,16 +2,38 @@
 #include <cstdint>
 
 namespace engine {
+    // Generational handle: the low 22 bits index a slot in World, the high 10 bits
+    // count how many times that slot has been reused. A stale ID keeps its old
+    // generation and therefore never matches the entity that recycled its slot.
+    // World throws rather than hand out more than 2^22 slots.
     using EntityID = std::uint32_t;
+
+    constexpr std::uint32_t ENTITY_INDEX_BITS = 22;
+    constexpr std::uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+    constexpr std::uint32_t ENTITY_GENERATION_MASK = (1u << (32 - ENTITY_INDEX_BITS)) - 1;
+
+    // Slot 0 is never handed out, so 0 stays "no entity" (e.g. an unowned component)
+    constexpr EntityID NULL_ENTITY = 0;
+
+    // World never issues this generation; CommandBuffer uses it to tag
+    // placeholder IDs for entities that will only exist after playback
+    constexpr std::uint32_t ENTITY_RESERVED_GENERATION = ENTITY_GENERATION_MASK;
+
+    constexpr std::uint32_t entityIndex(EntityID id) { return id & ENTITY_INDEX_MASK; }
+    constexpr std::uint32_t entityGeneration(EntityID id) { return id >> ENTITY_INDEX_BITS; }
+    constexpr EntityID makeEntityID(std::uint32_t index, std::uint32_t generation) {
+        return ((generation & ENTITY_GENERATION_MASK) << ENTITY_INDEX_BITS) | (index & ENTITY_INDEX_MASK);
+    }
     
+    // Components are stored by value in per-type pools, so the base is
+    // deliberately non-polymorphic: plain-data components stay trivially
+    // destructible and can be dropped wholesale by World::clear().
     class Component {
     public:
-        virtual ~Component() = default;
         EntityID getOwner() const { return ownerID; }
     protected:
-        EntityID ownerID = 0;
+        EntityID ownerID = NULL_ENTITY;
         friend class Entity;
         friend class World;
-        friend class TileSystem;
     };
 }
\ No newline at end of file
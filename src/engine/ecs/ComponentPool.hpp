@@ -0,0 +1,231 @@
+#pragma once
+#include <atomic>
+#include <deque>
+#include <vector>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "Component.hpp"
+#include "../core/ChunkArena.hpp"
+
+namespace engine {
+    // Untyped half of a pool: the dense list of owners and the sparse
+    // entity index -> slot table. Membership tests live here so that joins over
+    // several pools can check them without knowing the component types.
+    // The sparse table is keyed by entityIndex(), and the stored owner is compared
+    // in full, so a stale generation never resolves to a recycled entity's data.
+    //
+    // Change tracking: every dense slot carries the World tick at which its
+    // component was last added or marked changed, and every page of slots keeps
+    // the maximum of those ticks, so "changed since N" scans skip untouched pages.
+    class SparseSet {
+    public:
+        static constexpr std::uint32_t npos = ~std::uint32_t(0);
+        static constexpr std::size_t PAGE_SHIFT = 10;
+        static constexpr std::size_t PAGE_SIZE = std::size_t(1) << PAGE_SHIFT;
+        static constexpr std::size_t PAGE_MASK = PAGE_SIZE - 1;
+
+        virtual ~SparseSet() = default;
+        virtual void remove(EntityID id) = 0;
+        virtual void clear() = 0;
+
+        bool contains(EntityID id) const {
+            std::uint32_t index = entityIndex(id);
+            return index < sparse.size() && sparse[index] != npos && entities[sparse[index]] == id;
+        }
+
+        std::size_t size() const { return entities.size(); }
+        const EntityID* entityData() const { return entities.data(); }
+
+        // Safe to call concurrently for different entities (e.g. from parallelEach)
+        void markChanged(EntityID id, std::uint32_t tick) {
+            if (!contains(id)) return;
+            std::uint32_t slot = sparse[entityIndex(id)];
+            ticks[slot] = tick;
+            raiseTick(pageTicks[slot >> PAGE_SHIFT], tick);
+            raiseTick(lastChangedTick, tick);
+        }
+
+        std::uint32_t getChangedTick(EntityID id) const {
+            return contains(id) ? ticks[sparse[entityIndex(id)]] : 0;
+        }
+
+        std::uint32_t getLastChangedTick() const { return lastChangedTick.load(std::memory_order_relaxed); }
+        std::uint32_t getLastRemovedTick() const { return lastRemovedTick; }
+        void setLastRemovedTick(std::uint32_t tick) { lastRemovedTick = tick; }
+
+        // Grows the sparse table up front so that a batch of adds never resizes it
+        void reserveIndices(std::size_t indexCount) {
+            if (sparse.size() < indexCount) {
+                sparse.resize(indexCount, npos);
+            }
+        }
+
+    protected:
+        std::vector<EntityID> entities;
+        std::vector<std::uint32_t> sparse;
+        std::vector<std::uint32_t> ticks;
+        std::deque<std::atomic<std::uint32_t>> pageTicks;
+        std::atomic<std::uint32_t> lastChangedTick{0};
+        std::uint32_t lastRemovedTick = 0;
+
+        static void raiseTick(std::atomic<std::uint32_t>& target, std::uint32_t tick) {
+            std::uint32_t current = target.load(std::memory_order_relaxed);
+            while (current < tick &&
+                   !target.compare_exchange_weak(current, tick, std::memory_order_relaxed)) {
+            }
+        }
+
+        void addPageTick() {
+            pageTicks.emplace_back(0);
+        }
+
+        void resetTicks() {
+            ticks.clear();
+            for (auto& tick : pageTicks) {
+                tick.store(0, std::memory_order_relaxed);
+            }
+            lastChangedTick.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    // Sparse set: components of one type live densely in fixed-size pages carved
+    // out of the owning World's ChunkArena. `entities[i]` is the owner of slot i,
+    // and `sparse[index]` maps an entity back to its dense slot.
+    // Adding never moves existing components (pages are not reallocated); removal
+    // swaps the last element into the hole, so only the moved one changes address.
+    // clear() keeps the pages for reuse and skips destructors entirely for
+    // trivially destructible components; the memory goes back with the arena.
+    template<typename T>
+    class ComponentPool : public SparseSet {
+    public:
+        explicit ComponentPool(ChunkArena& arena) : arena(arena) {}
+
+        ~ComponentPool() override { destroyAll(); }
+
+        ComponentPool(const ComponentPool&) = delete;
+        ComponentPool& operator=(const ComponentPool&) = delete;
+
+        template<typename... Args>
+        T& emplace(EntityID id, Args&&... args) {
+            std::uint32_t index = entityIndex(id);
+            if (index >= sparse.size()) {
+                sparse.resize(static_cast<std::size_t>(index) + 1, npos);
+            }
+
+            std::uint32_t& slot = sparse[index];
+            if (slot != npos && entities[slot] == id) {
+                // Same semantics as before: adding an existing component replaces it
+                at(slot) = T(std::forward<Args>(args)...);
+                return at(slot);
+            }
+
+            // A slot left behind by a dead generation is simply overwritten
+            if (slot != npos) {
+                remove(entities[slot]);
+            }
+
+            std::size_t newSlot = entities.size();
+            if (newSlot == pages.size() * PAGE_SIZE) {
+                addPage();
+            }
+            T* component = new (&at(newSlot)) T(std::forward<Args>(args)...);
+            slot = static_cast<std::uint32_t>(newSlot);
+            entities.push_back(id);
+            ticks.push_back(0);
+            return *component;
+        }
+
+        T* get(EntityID id) {
+            return contains(id) ? &at(sparse[entityIndex(id)]) : nullptr;
+        }
+
+        const T* get(EntityID id) const {
+            return contains(id) ? &at(sparse[entityIndex(id)]) : nullptr;
+        }
+
+        // Caller guarantees contains(id)
+        T& getUnchecked(EntityID id) { return at(sparse[entityIndex(id)]); }
+        const T& getUnchecked(EntityID id) const { return at(sparse[entityIndex(id)]); }
+
+        void remove(EntityID id) override {
+            if (!contains(id)) return;
+
+            std::uint32_t index = entityIndex(id);
+            std::uint32_t slot = sparse[index];
+            std::uint32_t last = static_cast<std::uint32_t>(entities.size() - 1);
+            if (slot != last) {
+                at(slot) = std::move(at(last));
+                entities[slot] = entities[last];
+                ticks[slot] = ticks[last];
+                raiseTick(pageTicks[slot >> PAGE_SHIFT], ticks[slot]);
+                sparse[entityIndex(entities[slot])] = slot;
+            }
+            at(last).~T();
+            entities.pop_back();
+            ticks.pop_back();
+            sparse[index] = npos;
+        }
+
+        void clear() override {
+            destroyAll();
+            entities.clear();
+            sparse.clear();
+            resetTicks();
+        }
+
+        // Pre-allocates pages so that the next `count` adds do not touch the arena
+        void reserve(std::size_t count) {
+            while (pages.size() * PAGE_SIZE < count) {
+                addPage();
+            }
+            entities.reserve(count);
+            ticks.reserve(count);
+        }
+
+        T& at(std::size_t slot) { return pages[slot >> PAGE_SHIFT][slot & PAGE_MASK]; }
+        const T& at(std::size_t slot) const { return pages[slot >> PAGE_SHIFT][slot & PAGE_MASK]; }
+
+        // Page-wise access for tight loops: page i holds getPageLength(i) components
+        std::size_t getPageCount() const { return (size() + PAGE_SIZE - 1) >> PAGE_SHIFT; }
+        T* getPage(std::size_t page) const { return pages[page]; }
+        std::size_t getPageLength(std::size_t page) const {
+            std::size_t begin = page << PAGE_SHIFT;
+            return size() - begin < PAGE_SIZE ? size() - begin : PAGE_SIZE;
+        }
+
+        // fn(EntityID, T&) for every component added or marked changed after
+        // sinceTick; pages whose newest change is older are skipped wholesale
+        template<typename Func>
+        void eachChangedSince(std::uint32_t sinceTick, Func&& fn) {
+            if (getLastChangedTick() <= sinceTick) return;
+            for (std::size_t page = 0, count = getPageCount(); page < count; ++page) {
+                if (pageTicks[page].load(std::memory_order_relaxed) <= sinceTick) continue;
+                std::size_t begin = page << PAGE_SHIFT;
+                for (std::size_t slot = begin, end = begin + getPageLength(page); slot < end; ++slot) {
+                    if (ticks[slot] > sinceTick) {
+                        fn(entities[slot], at(slot));
+                    }
+                }
+            }
+        }
+
+    private:
+        ChunkArena& arena;
+        std::vector<T*> pages;
+
+        void addPage() {
+            pages.push_back(arena.allocateArray<T>(PAGE_SIZE));
+            addPageTick();
+        }
+
+        void destroyAll() {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                for (std::size_t i = 0, n = size(); i < n; ++i) {
+                    at(i).~T();
+                }
+            }
+        }
+    };
+}
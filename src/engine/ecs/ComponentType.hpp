@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace engine {
+    using ComponentTypeID = std::uint32_t;
+
+    // One bit per component type; a World keeps one mask per entity
+    using ComponentMask = std::uint64_t;
+    constexpr ComponentTypeID MAX_COMPONENT_TYPES = 64;
+
+    namespace detail {
+        inline ComponentTypeID nextComponentTypeID() {
+            static std::atomic<ComponentTypeID> counter{0};
+            ComponentTypeID id = counter.fetch_add(1, std::memory_order_relaxed);
+            // Every ID must fit into ComponentMask
+            if (id >= MAX_COMPONENT_TYPES) {
+                throw std::runtime_error("Too many component types registered");
+            }
+            return id;
+        }
+    }
+
+    // Dense, per-type ID assigned once on first use (no RTTI, no hashing).
+    // IDs are stable for the lifetime of the process and index World's pool table.
+    template<typename T>
+    ComponentTypeID getComponentTypeID() {
+        static const ComponentTypeID id = detail::nextComponentTypeID();
+        return id;
+    }
+
+    template<typename T>
+    ComponentMask getComponentMask() {
+        return ComponentMask(1) << getComponentTypeID<std::remove_const_t<T>>();
+    }
+
+    template<typename... Ts>
+    ComponentMask makeComponentMask() {
+        return (ComponentMask(0) | ... | getComponentMask<Ts>());
+    }
+}
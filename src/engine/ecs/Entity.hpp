@@ -1,34 +1,39 @@
 #pragma once
-#include <unordered_map>
-#include <memory>
-#include <typeindex>
 #include "Component.hpp"
+#include "ComponentType.hpp"
 
 namespace engine {
+    class World;
+
+    // Lightweight handle: components are stored per type inside World,
+    // Entity only forwards to it. Template bodies are defined in World.hpp.
     class Entity {
     public:
-        explicit Entity(EntityID id) : id(id) {}
+        Entity(EntityID id, World* world) : id(id), world(world) {}
         
         template<typename T, typename... Args>
-        T* addComponent(Args&&... args) {
-            auto component = std::make_unique<T>(std::forward<Args>(args)...);
-            component->ownerID = id;
-            auto ptr = component.get();
-            components[std::type_index(typeid(T))] = std::move(component);
-            return ptr;
-        }
+        T* addComponent(Args&&... args);
+
+        template<typename T>
+        T* getComponent();
+
+        template<typename T>
+        const T* getComponent() const;
+
+        template<typename T>
+        bool hasComponent() const;
 
         template<typename T>
-        const T* getComponent() const {
-            auto it = components.find(std::type_index(typeid(T)));
-            return it != components.end() ? static_cast<T*>(it->second.get()) : nullptr;
-        }
+        void removeComponent();
 
         EntityID getID() const { return id; }
+        ComponentMask getSignature() const { return signature; }
 
     private:
         EntityID id;
-        std::unordered_map<std::type_index, std::unique_ptr<Component>> components;
+        World* world;
+        bool alive = true;
+        ComponentMask signature = 0;
         friend class World;
     };
 }
\ No newline at end of file
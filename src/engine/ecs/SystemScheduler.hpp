@@ -0,0 +1,174 @@
+#pragma once
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+#include "World.hpp"
+#include "CommandBuffer.hpp"
+#include "../core/ThreadPool.hpp"
+
+namespace engine {
+    // What a system touches, as component masks. Two systems conflict when one
+    // writes a type the other reads or writes; systems that do not conflict may
+    // run at the same time. mainThread pins a system (e.g. anything issuing GL
+    // calls) to the thread that calls SystemScheduler::run.
+    struct SystemAccess {
+        ComponentMask reads = 0;
+        ComponentMask writes = 0;
+        bool mainThread = false;
+
+        template<typename... Ts>
+        SystemAccess& read() {
+            reads |= makeComponentMask<Ts...>();
+            return *this;
+        }
+
+        template<typename... Ts>
+        SystemAccess& write() {
+            writes |= makeComponentMask<Ts...>();
+            return *this;
+        }
+
+        SystemAccess& onMainThread() {
+            mainThread = true;
+            return *this;
+        }
+
+        bool conflictsWith(const SystemAccess& other) const {
+            return (writes & (other.reads | other.writes)) != 0 ||
+                   (other.writes & reads) != 0;
+        }
+    };
+
+    // Runs registered systems once per run() call. Systems are grouped into
+    // stages: a system goes into the first stage after every earlier-registered
+    // system it conflicts with, so registration order is preserved wherever it
+    // matters. Systems within a stage run concurrently on the thread pool (main
+    // thread systems on the caller), and each stage ends with a sync point.
+    //
+    // Every system gets its own CommandBuffer for structural changes; buffers of
+    // a stage are played back at its sync point, in registration order, so
+    // systems never create/destroy entities or add/remove components while
+    // other systems are iterating the World.
+    class SystemScheduler {
+    public:
+        using SystemFunc = std::function<void(World&, CommandBuffer&)>;
+
+        explicit SystemScheduler(ThreadPool& threadPool) : threadPool(threadPool) {}
+
+        void addSystem(const std::string& name, const SystemAccess& access, SystemFunc fn) {
+            systems.push_back({name, access, std::move(fn), CommandBuffer()});
+            stagesDirty = true;
+        }
+
+        // For systems that never make structural changes
+        void addSystem(const std::string& name, const SystemAccess& access,
+                       std::function<void(World&)> fn) {
+            addSystem(name, access, [fn = std::move(fn)](World& world, CommandBuffer&) { fn(world); });
+        }
+
+        void run(World& world) {
+            if (stagesDirty) {
+                buildStages();
+            }
+
+            std::vector<std::future<void>> pending;
+            for (const auto& stage : stages) {
+                pending.clear();
+                System* mainThreadSystems[MAX_STAGE_SIZE];
+                std::size_t mainThreadCount = 0;
+
+                for (std::size_t index : stage) {
+                    System& system = systems[index];
+                    if (system.access.mainThread || stage.size() == 1) {
+                        mainThreadSystems[mainThreadCount++] = &system;
+                    } else {
+                        pending.push_back(threadPool.submit([&system, &world]() {
+                            system.fn(world, system.commands);
+                        }));
+                    }
+                }
+
+                std::exception_ptr error;
+                try {
+                    for (std::size_t i = 0; i < mainThreadCount; ++i) {
+                        mainThreadSystems[i]->fn(world, mainThreadSystems[i]->commands);
+                    }
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                // Sync point. Pool tasks reference the system and the world, so
+                // every one is waited for before the first exception is rethrown
+                for (auto& result : pending) {
+                    try {
+                        result.get();
+                    } catch (...) {
+                        if (!error) error = std::current_exception();
+                    }
+                }
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                for (std::size_t index : stage) {
+                    systems[index].commands.playback(world);
+                }
+            }
+        }
+
+        // Stage layout for debugging/UI: names per stage in execution order
+        std::vector<std::vector<std::string>> getStageNames() {
+            if (stagesDirty) {
+                buildStages();
+            }
+            std::vector<std::vector<std::string>> names;
+            for (const auto& stage : stages) {
+                names.emplace_back();
+                for (std::size_t index : stage) {
+                    names.back().push_back(systems[index].name);
+                }
+            }
+            return names;
+        }
+
+    private:
+        static constexpr std::size_t MAX_STAGE_SIZE = 64;
+
+        struct System {
+            std::string name;
+            SystemAccess access;
+            SystemFunc fn;
+            CommandBuffer commands;
+        };
+
+        ThreadPool& threadPool;
+        std::vector<System> systems;
+        std::vector<std::vector<std::size_t>> stages;
+        bool stagesDirty = false;
+
+        void buildStages() {
+            stages.clear();
+            std::vector<std::size_t> stageOf(systems.size(), 0);
+
+            for (std::size_t i = 0; i < systems.size(); ++i) {
+                std::size_t stage = 0;
+                for (std::size_t j = 0; j < i; ++j) {
+                    if (systems[i].access.conflictsWith(systems[j].access)) {
+                        stage = std::max(stage, stageOf[j] + 1);
+                    }
+                }
+                // Keep stages bounded so run() can use a fixed-size scratch array
+                while (stage < stages.size() && stages[stage].size() >= MAX_STAGE_SIZE) {
+                    ++stage;
+                }
+                stageOf[i] = stage;
+                if (stage >= stages.size()) {
+                    stages.resize(stage + 1);
+                }
+                stages[stage].push_back(i);
+            }
+            stagesDirty = false;
+        }
+    };
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <iterator>
+#include <type_traits>
+#include "ComponentPool.hpp"
+
+namespace engine {
+    // Non-owning view over the dense storage of one component pool.
+    // The pool itself is kept up to date by World on every add/remove, so a view
+    // never has to be rebuilt: begin()/end() always reflect the current contents
+    // and iterating allocates nothing. Valid for as long as the World it came from.
+    template<typename T>
+    class ComponentView {
+    public:
+        using PoolType = std::conditional_t<std::is_const_v<T>,
+                                            const ComponentPool<std::remove_const_t<T>>,
+                                            ComponentPool<std::remove_const_t<T>>>;
+
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::remove_const_t<T>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = T*;
+            using reference = T&;
+
+            Iterator(PoolType* pool, std::size_t slot) : pool(pool), slot(slot) {}
+
+            T& operator*() const { return pool->at(slot); }
+            T* operator->() const { return &pool->at(slot); }
+            Iterator& operator++() { ++slot; return *this; }
+            Iterator operator++(int) { Iterator tmp = *this; ++slot; return tmp; }
+            bool operator==(const Iterator& other) const { return slot == other.slot; }
+            bool operator!=(const Iterator& other) const { return slot != other.slot; }
+
+        private:
+            PoolType* pool;
+            std::size_t slot;
+        };
+
+        ComponentView() = default;
+        explicit ComponentView(PoolType* pool) : pool(pool) {}
+
+        Iterator begin() const { return Iterator(pool, 0); }
+        Iterator end() const { return Iterator(pool, size()); }
+
+        std::size_t size() const { return pool ? pool->size() : 0; }
+        bool empty() const { return size() == 0; }
+
+        T& operator[](std::size_t index) const { return pool->at(index); }
+        EntityID entity(std::size_t index) const { return pool->entityData()[index]; }
+
+        // fn(EntityID, T&), walking one contiguous page at a time
+        template<typename Func>
+        void each(Func&& fn) const {
+            if (!pool) return;
+            const EntityID* owners = pool->entityData();
+            for (std::size_t page = 0, pages = pool->getPageCount(); page < pages; ++page) {
+                T* data = pool->getPage(page);
+                const EntityID* pageOwners = owners + (page << PoolType::PAGE_SHIFT);
+                for (std::size_t i = 0, n = pool->getPageLength(page); i < n; ++i) {
+                    fn(pageOwners[i], data[i]);
+                }
+            }
+        }
+
+    private:
+        PoolType* pool = nullptr;
+    };
+}
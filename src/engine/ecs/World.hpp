@@ -1,42 +1,458 @@
 #pragma once
+#include <atomic>
 #include <vector>
+#include <new>
 #include <memory>
-#include <unordered_map>
+#include <stdexcept>
+#include <tuple>
 #include "Entity.hpp"
+#include "ComponentType.hpp"
+#include "ComponentPool.hpp"
+#include "View.hpp"
 
 namespace engine {
     class World {
     public:
+        World() = default;
+
+        World(const World&) = delete;
+        World& operator=(const World&) = delete;
+
+        World(World&& other) noexcept { swap(other); }
+
+        World& operator=(World&& other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        // Reuses the most recently freed slot with a bumped generation, otherwise
+        // appends a new one. Slots live in arena pages, so Entity* stays valid.
         Entity* createEntity() {
-            auto entity = std::make_unique<Entity>(nextEntityID++);
-            auto ptr = entity.get();
-            entities[entity->getID()] = std::move(entity);
-            return ptr;
+            if (slotCount == 0) {
+                // Slot 0 backs NULL_ENTITY and is never alive
+                appendSlot(NULL_ENTITY).alive = false;
+            }
+
+            Entity* entity;
+            if (!freeSlots.empty()) {
+                std::uint32_t index = freeSlots.back();
+                freeSlots.pop_back();
+                entity = &slot(index);
+                // Wraps before ENTITY_RESERVED_GENERATION
+                std::uint32_t generation = (entityGeneration(entity->id) + 1) % ENTITY_RESERVED_GENERATION;
+                entity->id = makeEntityID(index, generation);
+                entity->alive = true;
+            } else {
+                entity = &appendSlot(makeEntityID(slotCount, 0));
+            }
+            ++aliveCount;
+            return entity;
+        }
+
+        // Batch creation: reserves slots and component pages once, then creates
+        // `count` entities that each get default-constructed Ts... and calls
+        // init(i, id, Ts&...) so the caller can fill them straight from its own
+        // (SoA) arrays. Cheaper than createEntity + addComponent per entity.
+        template<typename... Ts, typename Init>
+        void createEntities(std::size_t count, Init&& init) {
+            reserveEntities(count);
+            const std::uint32_t tick = getTick();
+            const ComponentMask signature = makeComponentMask<Ts...>();
+            auto pools = std::make_tuple(&getPool<Ts>()...);
+            std::apply([&](auto*... pool) {
+                (pool->reserve(pool->size() + count), ...);
+                (pool->reserveIndices(slotCount + count), ...);
+
+                for (std::size_t i = 0; i < count; ++i) {
+                    Entity* entity = createEntity();
+                    EntityID id = entity->id;
+                    entity->signature = signature;
+                    init(i, id, emplaceOwned(*pool, id, tick)...);
+                }
+            }, pools);
+        }
+
+        template<typename... Ts>
+        void createEntities(std::size_t count) {
+            createEntities<Ts...>(count, [](std::size_t, EntityID, Ts&...) {});
+        }
+
+        // Pre-allocates pool pages for `count` more T components
+        template<typename T>
+        void reserve(std::size_t count) {
+            auto& pool = getPool<T>();
+            pool.reserve(pool.size() + count);
+        }
+
+        // Makes sure the next `count` createEntity() calls do not allocate slot pages
+        void reserveEntities(std::size_t count) {
+            // Slot 0 is taken by NULL_ENTITY before the first entity
+            std::size_t needed = std::size_t(slotCount == 0 ? 1 : slotCount)
+                               + (count > freeSlots.size() ? count - freeSlots.size() : 0);
+            if (needed > std::size_t(ENTITY_INDEX_MASK) + 1) {
+                throw std::runtime_error("Too many entities");
+            }
+            while (slotPages.size() * SLOT_PAGE_SIZE < needed) {
+                slotPages.push_back(getArena().allocateArray<Entity>(SLOT_PAGE_SIZE));
+            }
         }
 
         void destroyEntity(EntityID id) {
-            entities.erase(id);
+            Entity* entity = getEntity(id);
+            if (!entity) return;
+
+            // Only visit the pools this entity actually has components in
+            for (ComponentMask mask = entity->signature; mask != 0; mask &= mask - 1) {
+                SparseSet& pool = *pools[lowestBit(mask)];
+                pool.remove(id);
+                pool.setLastRemovedTick(getTick());
+            }
+            entity->signature = 0;
+            entity->alive = false;
+            freeSlots.push_back(entityIndex(id));
+            --aliveCount;
         }
 
+        // O(1): index into the slot table and compare generations
         Entity* getEntity(EntityID id) const {
-            auto it = entities.find(id);
-            return it != entities.end() ? it->second.get() : nullptr;
+            std::uint32_t index = entityIndex(id);
+            if (index >= slotCount) return nullptr;
+            Entity& entity = const_cast<World*>(this)->slot(index);
+            return entity.alive && entity.id == id ? &entity : nullptr;
         }
 
-        template<typename T>
-        std::vector<T*> getComponents() const {
-            std::vector<T*> result;
-            for (const auto& [id, entity] : entities) {
-                // Use const_cast to remove const-ness when adding to result
-                if (auto comp = const_cast<T*>(entity->getComponent<T>())) {
-                    result.push_back(comp);
+        bool isAlive(EntityID id) const { return getEntity(id) != nullptr; }
+        std::size_t getEntityCount() const { return aliveCount; }
+
+        // Drops every entity and component but keeps all arena pages for reuse,
+        // so regenerating a map of the same size allocates nothing. Trivially
+        // destructible components are discarded without touching them.
+        // Slots keep their generations and are recycled like destroyed ones,
+        // so previously issued EntityIDs never match the new entities.
+        void clear() {
+            for (auto& pool : pools) {
+                if (pool) {
+                    pool->clear();
+                    pool->setLastRemovedTick(getTick());
                 }
             }
-            return result;
+            freeSlots.clear();
+            // Lowest index on top, so new entities fill the slots in order
+            for (std::uint32_t index = slotCount; index-- > 1;) {
+                Entity& entity = slot(index);
+                entity.signature = 0;
+                entity.alive = false;
+                freeSlots.push_back(index);
+            }
+            aliveCount = 0;
+        }
+
+        template<typename T, typename... Args>
+        T* addComponent(EntityID id, Args&&... args) {
+            Entity* entity = getEntity(id);
+            if (!entity) return nullptr;
+
+            auto& pool = getPool<T>();
+            T& component = pool.emplace(id, std::forward<Args>(args)...);
+            component.ownerID = id;
+            pool.markChanged(id, getTick());
+            entity->signature |= getComponentMask<T>();
+            return &component;
+        }
+
+        template<typename T>
+        T* getComponent(EntityID id) {
+            auto* pool = findPool<T>();
+            return pool ? pool->get(id) : nullptr;
+        }
+
+        template<typename T>
+        const T* getComponent(EntityID id) const {
+            auto* pool = findPool<T>();
+            return pool ? pool->get(id) : nullptr;
+        }
+
+        template<typename T>
+        bool hasComponent(EntityID id) const {
+            const Entity* entity = getEntity(id);
+            return entity && (entity->signature & getComponentMask<T>()) != 0;
+        }
+
+        template<typename T>
+        void removeComponent(EntityID id) {
+            Entity* entity = getEntity(id);
+            if (!entity) return;
+
+            if (auto* pool = findPool<T>()) {
+                pool->remove(id);
+                pool->setLastRemovedTick(getTick());
+            }
+            entity->signature &= ~getComponentMask<T>();
+        }
+
+        ComponentMask getSignature(EntityID id) const {
+            const Entity* entity = getEntity(id);
+            return entity ? entity->signature : 0;
+        }
+
+        // Change ticks. Adding a component stamps it with the current tick, and
+        // in-place writes are reported with markChanged()/patch(). A consumer
+        // that keeps a derived cache calls advanceTick() at its sync point and
+        // remembers the returned tick; eachChanged<T>(thatTick, ...) on its next
+        // run yields exactly the components touched since (writes that happen
+        // after the call are stamped with a newer tick). Removals are tracked per
+        // type only: getLastRemovedTick<T>() > thatTick means entries went away.
+        std::uint32_t getTick() const { return currentTick.load(std::memory_order_relaxed); }
+
+        // Starts a new tick and returns the one that just ended
+        std::uint32_t advanceTick() { return currentTick.fetch_add(1, std::memory_order_relaxed); }
+
+        template<typename T>
+        void markChanged(EntityID id) {
+            if (auto* pool = findPool<T>()) {
+                pool->markChanged(id, getTick());
+            }
+        }
+
+        // Applies fn(T&) and marks the component changed; false if id has no T
+        template<typename T, typename Func>
+        bool patch(EntityID id, Func&& fn) {
+            auto* pool = findPool<T>();
+            T* component = pool ? pool->get(id) : nullptr;
+            if (!component) return false;
+            fn(*component);
+            pool->markChanged(id, getTick());
+            return true;
+        }
+
+        // fn(EntityID, T&) for every T added or marked changed after sinceTick
+        template<typename T, typename Func>
+        void eachChanged(std::uint32_t sinceTick, Func&& fn) {
+            if (auto* pool = findPool<T>()) {
+                pool->eachChangedSince(sinceTick, std::forward<Func>(fn));
+            }
+        }
+
+        template<typename T>
+        std::uint32_t getChangedTick(EntityID id) const {
+            auto* pool = findPool<T>();
+            return pool ? pool->getChangedTick(id) : 0;
+        }
+
+        template<typename T>
+        std::uint32_t getLastChangedTick() const {
+            auto* pool = findPool<T>();
+            return pool ? pool->getLastChangedTick() : 0;
+        }
+
+        template<typename T>
+        std::uint32_t getLastRemovedTick() const {
+            auto* pool = findPool<T>();
+            return pool ? pool->getLastRemovedTick() : 0;
+        }
+
+        // Persistent view over all T components. Creates the pool on first use so the
+        // view stays live even if it is taken before any T has been added.
+        template<typename T>
+        ComponentView<T> view() {
+            return ComponentView<T>(&getPool<T>());
+        }
+
+        template<typename T>
+        ComponentView<const T> view() const {
+            return ComponentView<const T>(findPool<T>());
+        }
+
+        // Join: calls fn(EntityID, Ts&...) for every entity that has all of Ts.
+        // Drives the loop from the smallest pool and matches candidates with a
+        // single mask test against the entity's signature, so the cost is
+        // O(min pool size) with no hashing and no probing of the other pools.
+        // Do not add/remove any of Ts from inside fn.
+        template<typename... Ts, typename Func>
+        void each(Func&& fn) {
+            eachImpl(makeComponentMask<Ts...>(), std::make_tuple(findPool<Ts>()...),
+                     std::forward<Func>(fn));
+        }
+
+        template<typename... Ts, typename Func>
+        void each(Func&& fn) const {
+            eachImpl(makeComponentMask<Ts...>(),
+                std::make_tuple(static_cast<const ComponentPool<Ts>*>(findPool<Ts>())...),
+                std::forward<Func>(fn));
+        }
+
+        // Same contract as each(), but splits the driving pool into chunks that
+        // run on OpenMP worker threads. fn may only modify the components it is
+        // handed (no structural changes, no writes to other entities); small
+        // queries fall back to a serial loop.
+        template<typename... Ts, typename Func>
+        void parallelEach(Func&& fn) {
+            auto pools = std::make_tuple(findPool<Ts>()...);
+            const ComponentMask required = makeComponentMask<Ts...>();
+            std::apply([&](auto*... pool) {
+                if (((pool == nullptr) || ...)) return;
+
+                const SparseSet* driver = nullptr;
+                ((driver = (!driver || pool->size() < driver->size()) ? pool : driver), ...);
+
+                const EntityID* owners = driver->entityData();
+                const std::ptrdiff_t count = static_cast<std::ptrdiff_t>(driver->size());
+                #pragma omp parallel for schedule(static) if(count >= PARALLEL_EACH_THRESHOLD)
+                for (std::ptrdiff_t i = 0; i < count; ++i) {
+                    EntityID id = owners[i];
+                    const Entity& entity = slotPages[entityIndex(id) >> SLOT_PAGE_SHIFT]
+                                                    [entityIndex(id) & (SLOT_PAGE_SIZE - 1)];
+                    if ((entity.signature & required) == required) {
+                        fn(id, pool->getUnchecked(id)...);
+                    }
+                }
+            }, pools);
         }
 
     private:
-        EntityID nextEntityID = 1;
-        std::unordered_map<EntityID, std::unique_ptr<Entity>> entities;
+        static constexpr std::ptrdiff_t PARALLEL_EACH_THRESHOLD = 4096;
+        static constexpr std::uint32_t SLOT_PAGE_SHIFT = 12;
+        static constexpr std::uint32_t SLOT_PAGE_SIZE = 1u << SLOT_PAGE_SHIFT;
+
+        // Declared first so that it outlives the pools carved out of it
+        std::unique_ptr<ChunkArena> arena;
+        std::vector<Entity*> slotPages;
+        std::uint32_t slotCount = 0;
+        std::vector<std::uint32_t> freeSlots;
+        std::size_t aliveCount = 0;
+        // Starts at 1 so that a consumer's initial "seen" tick of 0 covers everything
+        std::atomic<std::uint32_t> currentTick{1};
+        // Indexed by ComponentTypeID
+        std::vector<std::unique_ptr<SparseSet>> pools;
+
+        ChunkArena& getArena() {
+            if (!arena) {
+                arena = std::make_unique<ChunkArena>();
+            }
+            return *arena;
+        }
+
+        Entity& slot(std::uint32_t index) {
+            return slotPages[index >> SLOT_PAGE_SHIFT][index & (SLOT_PAGE_SIZE - 1)];
+        }
+
+        Entity& appendSlot(EntityID id) {
+            // Slot indices must fit into the low ENTITY_INDEX_BITS of an EntityID
+            if (slotCount > ENTITY_INDEX_MASK) {
+                throw std::runtime_error("Too many entities");
+            }
+            if (slotCount == slotPages.size() * SLOT_PAGE_SIZE) {
+                slotPages.push_back(getArena().allocateArray<Entity>(SLOT_PAGE_SIZE));
+            }
+            // Entity is trivially destructible, so slots are never destroyed explicitly
+            Entity* entity = new (&slotPages[slotCount >> SLOT_PAGE_SHIFT][slotCount & (SLOT_PAGE_SIZE - 1)])
+                Entity(id, this);
+            ++slotCount;
+            return *entity;
+        }
+
+        void swap(World& other) noexcept {
+            std::swap(arena, other.arena);
+            std::swap(slotPages, other.slotPages);
+            std::swap(slotCount, other.slotCount);
+            std::swap(freeSlots, other.freeSlots);
+            std::swap(aliveCount, other.aliveCount);
+            std::swap(pools, other.pools);
+            std::uint32_t tick = currentTick.load(std::memory_order_relaxed);
+            currentTick.store(other.currentTick.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            other.currentTick.store(tick, std::memory_order_relaxed);
+            // Entity handles point back to their world
+            rebindSlots();
+            other.rebindSlots();
+        }
+
+        void rebindSlots() {
+            for (std::uint32_t i = 0; i < slotCount; ++i) {
+                slot(i).world = this;
+            }
+        }
+
+        template<typename T>
+        ComponentPool<T>& getPool() {
+            ComponentTypeID type = getComponentTypeID<T>();
+            if (type >= pools.size()) {
+                pools.resize(static_cast<std::size_t>(type) + 1);
+            }
+
+            auto& pool = pools[type];
+            if (!pool) {
+                pool = std::make_unique<ComponentPool<T>>(getArena());
+            }
+            return static_cast<ComponentPool<T>&>(*pool);
+        }
+
+        template<typename T>
+        ComponentPool<T>* findPool() const {
+            ComponentTypeID type = getComponentTypeID<T>();
+            return type < pools.size() ? static_cast<ComponentPool<T>*>(pools[type].get()) : nullptr;
+        }
+
+        template<typename T>
+        static T& emplaceOwned(ComponentPool<T>& pool, EntityID id, std::uint32_t tick) {
+            T& component = pool.emplace(id);
+            component.ownerID = id;
+            pool.markChanged(id, tick);
+            return component;
+        }
+
+        static ComponentTypeID lowestBit(ComponentMask mask) {
+            ComponentTypeID bit = 0;
+            while ((mask & 1) == 0) {
+                mask >>= 1;
+                ++bit;
+            }
+            return bit;
+        }
+
+        template<typename Pools, typename Func>
+        void eachImpl(ComponentMask required, const Pools& pools, Func&& fn) const {
+            std::apply([&](auto*... pool) {
+                if (((pool == nullptr) || ...)) return;
+
+                const SparseSet* driver = nullptr;
+                ((driver = (!driver || pool->size() < driver->size()) ? pool : driver), ...);
+
+                const EntityID* owners = driver->entityData();
+                for (std::size_t i = 0, n = driver->size(); i < n; ++i) {
+                    EntityID id = owners[i];
+                    // Pool owners are always alive, so the slot belongs to `id`
+                    const Entity& entity = slotPages[entityIndex(id) >> SLOT_PAGE_SHIFT]
+                                                    [entityIndex(id) & (SLOT_PAGE_SIZE - 1)];
+                    if ((entity.signature & required) == required) {
+                        fn(id, pool->getUnchecked(id)...);
+                    }
+                }
+            }, pools);
+        }
     };
+
+    template<typename T, typename... Args>
+    T* Entity::addComponent(Args&&... args) {
+        return world->addComponent<T>(id, std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    T* Entity::getComponent() {
+        return world->getComponent<T>(id);
+    }
+
+    template<typename T>
+    const T* Entity::getComponent() const {
+        return static_cast<const World*>(world)->getComponent<T>(id);
+    }
+
+    template<typename T>
+    bool Entity::hasComponent() const {
+        return world->hasComponent<T>(id);
+    }
+
+    template<typename T>
+    void Entity::removeComponent() {
+        world->removeComponent<T>(id);
+    }
 }
\ No newline at end of file
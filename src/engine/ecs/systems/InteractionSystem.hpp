@@ -1,24 +1,18 @@
 #pragma once
-#include "../World.hpp"
-#include "../components/TileComponent.hpp"
+#include "../../../game/world/ChunkedTileMap.hpp"
 #include <functional>
 
 namespace engine {
    class InteractionSystem {
    public:
-       using TileClickCallback = std::function<void(Entity*, const TileComponent*)>;
+       // Receives the clicked cell, the cells of its chunk and its index there
+       using TileClickCallback = std::function<void(const GridPosition&, const game::TileLayer&, std::size_t)>;
 
-       void processClick(World& world, const GridPosition& clickPos, const TileClickCallback& callback) {
-           auto tiles = world.getComponents<TileComponent>();
-           
-           for (const auto* tile : tiles) {
-               if (tile->gridPosition.x == clickPos.x && 
-                   tile->gridPosition.y == clickPos.y) {
-                   Entity* entity = const_cast<Entity*>(world.getEntity(tile->getOwner()));
-                   // Pass the const tile to the callback
-                   callback(entity, tile);
-                   break;
-               }
+       void processClick(const game::ChunkedTileMap& map, const GridPosition& clickPos, const TileClickCallback& callback) {
+           std::size_t index;
+           const game::TileChunk* chunk = map.findCell(clickPos, index);
+           if (chunk && chunk->cells.getType(index) != TileType::NONE) {
+               callback(clickPos, chunk->cells, index);
            }
        }
    };
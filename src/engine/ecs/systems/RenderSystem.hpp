@@ -1,35 +1,273 @@
 #pragma once
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
 #include "../Component.hpp"
 #include "../../core/Renderer.hpp"
 #include "../components/TransformComponent.hpp"
 #include "../components/RenderableComponent.hpp"
 #include "../World.hpp"
+#include "../SystemScheduler.hpp"
+#include "../CellSet.hpp"
+#include "TileSystem.hpp"
+#include "../../../game/world/ChunkedTileMap.hpp"
 
 namespace engine {
+    // Draws the tile layer and then every entity with Transform + Renderable.
+    //
+    // Tiles: every loaded chunk gets its own draw list bucketed by tile type
+    // (one batch per texture), rebuilt only when that chunk's version changes,
+    // and only chunks overlapping the view are drawn. Highlights are patched by
+    // diffing the highlighted CellSet against the previous frame's, so moving
+    // the cursor touches a handful of items.
+    //
+    // Entities: a draw list grouped by texture, patched from the World's change
+    // ticks; adds and removals rebuild it.
     class RenderSystem {
     public:
         explicit RenderSystem(Renderer& renderer) : renderer(renderer) {}
 
-        void render(World& world) {
-            auto renderables = world.getComponents<RenderableComponent>();
-            
-            for (auto* renderable : renderables) {
-                auto* transform = world.getEntity(renderable->getOwner())
-                    ->getComponent<TransformComponent>();
-                
-                if (!transform) continue;
+        // Issues GL calls, so it must stay on the thread that owns the context
+        static SystemAccess getAccess() {
+            return SystemAccess().read<TransformComponent, RenderableComponent>().onMainThread();
+        }
+
+        // viewMin/viewMax: visible cells (inclusive corners)
+        void render(World& world, const game::ChunkedTileMap& map, const CellSet& highlighted,
+                    const GridPosition& viewMin, const GridPosition& viewMax) {
+            syncTiles(map, highlighted);
+
+            visibleLists.clear();
+            auto low = game::ChunkedTileMap::chunkOf(viewMin);
+            auto high = game::ChunkedTileMap::chunkOf(viewMax);
+            for (int chunkY = low.y; chunkY <= high.y; ++chunkY) {
+                for (int chunkX = low.x; chunkX <= high.x; ++chunkX) {
+                    if (const game::TileChunk* chunk = map.findChunk(chunkX, chunkY)) {
+                        visibleLists.push_back(&syncChunk(*chunk));
+                    }
+                }
+            }
+            for (std::size_t type = 0; type < TILE_TYPE_COUNT; ++type) {
+                const auto& texture = map.getTexture(static_cast<TileType>(type));
+                if (!texture) continue;
+                for (const ChunkDrawList* list : visibleLists) {
+                    for (std::size_t i = list->typeStart[type]; i < list->typeStart[type + 1]; ++i) {
+                        const TileBatchItem& item = list->items[i];
+                        renderer.drawTile(item.position, item.size, texture,
+                                          item.isHighlighted != 0.0f, item.highlightColor);
+                    }
+                }
+            }
 
-                renderer.drawTile(
-                    transform->position,
-                    renderable->size,
-                    renderable->texture,
-                    renderable->isHighlighted,
-                    renderable->highlightColor
-                );
+            sync(world);
+            for (std::size_t i = 0; i < items.size(); ++i) {
+                const TileBatchItem& item = items[i];
+                renderer.drawTile(item.position, item.size, textures[i],
+                                  item.isHighlighted != 0.0f, item.highlightColor);
             }
         }
 
     private:
+        static constexpr std::uint32_t npos = ~std::uint32_t(0);
+        static inline const glm::vec4 TILE_HIGHLIGHT_COLOR{1.0f, 1.0f, 0.0f, 0.3f};
+
         Renderer& renderer;
+        std::vector<TileBatchItem> items;
+        std::vector<std::shared_ptr<Texture>> textures;
+        std::vector<EntityID> owners;
+        // entityIndex -> position in items
+        std::vector<std::uint32_t> itemOf;
+        const World* syncedWorld = nullptr;
+        std::uint32_t seenTick = 0;
+
+        // Draw list of one chunk. Items of type t occupy
+        // [typeStart[t], typeStart[t + 1]); itemOfCell maps a cell index to
+        // its item
+        struct ChunkDrawList {
+            const game::TileChunk* chunk = nullptr;
+            std::uint64_t serial = 0;
+            std::uint64_t version = 0;
+            std::vector<TileBatchItem> items;
+            std::size_t typeStart[TILE_TYPE_COUNT + 1] = {};
+            std::vector<std::uint32_t> itemOfCell;
+        };
+
+        std::unordered_map<std::uint64_t, ChunkDrawList> chunkLists;
+        std::vector<const ChunkDrawList*> visibleLists;
+        const game::ChunkedTileMap* syncedMap = nullptr;
+        std::uint64_t syncedMapVersion = 0;
+        CellSet shownHighlight;
+
+        void syncTiles(const game::ChunkedTileMap& map, const CellSet& highlighted) {
+            if (syncedMap != &map) {
+                chunkLists.clear();
+                syncedMap = &map;
+                syncedMapVersion = map.getVersion();
+            } else if (syncedMapVersion != map.getVersion()) {
+                // Chunks were loaded/evicted: drop lists whose chunk is gone
+                // (the old pointer may dangle, so compare serials by key)
+                for (auto it = chunkLists.begin(); it != chunkLists.end();) {
+                    const game::TileChunk* chunk = map.findChunk(static_cast<int>(it->first >> 32),
+                                                                 static_cast<int>(static_cast<std::uint32_t>(it->first)));
+                    if (!chunk || chunk->serial != it->second.serial) {
+                        it = chunkLists.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                syncedMapVersion = map.getVersion();
+            }
+            CellSet::forEachDifference(shownHighlight, highlighted, [&](const GridPosition& pos) {
+                setTileHighlight(pos, 0.0f);
+            });
+            CellSet::forEachDifference(highlighted, shownHighlight, [&](const GridPosition& pos) {
+                setTileHighlight(pos, 1.0f);
+            });
+            shownHighlight = highlighted;
+        }
+
+        // Lists that are stale get the right value on rebuild anyway
+        void setTileHighlight(const GridPosition& pos, float value) {
+            auto coord = game::ChunkedTileMap::chunkOf(pos);
+            auto it = chunkLists.find(game::ChunkedTileMap::chunkKey(coord.x, coord.y));
+            if (it != chunkLists.end()) {
+                ChunkDrawList& list = it->second;
+                list.items[list.itemOfCell[list.chunk->cells.cellIndex(pos)]].isHighlighted = value;
+            }
+        }
+
+        ChunkDrawList& syncChunk(const game::TileChunk& chunk) {
+            ChunkDrawList& list = chunkLists[game::ChunkedTileMap::chunkKey(chunk.chunkX, chunk.chunkY)];
+            if (list.serial != chunk.serial || list.version != chunk.cells.getVersion()) {
+                rebuildChunk(list, chunk);
+            }
+            return list;
+        }
+
+        // Counting sort of cells by type: two linear passes over the type array
+        void rebuildChunk(ChunkDrawList& list, const game::TileChunk& chunk) {
+            const game::TileLayer& cells = chunk.cells;
+            const std::size_t count = cells.getCellCount();
+            const TileType* types = cells.typeData();
+
+            std::fill(std::begin(list.typeStart), std::end(list.typeStart), 0);
+            for (std::size_t i = 0; i < count; ++i) {
+                ++list.typeStart[static_cast<std::size_t>(types[i]) + 1];
+            }
+            for (std::size_t type = 0; type < TILE_TYPE_COUNT; ++type) {
+                list.typeStart[type + 1] += list.typeStart[type];
+            }
+
+            std::size_t next[TILE_TYPE_COUNT];
+            std::copy(list.typeStart, list.typeStart + TILE_TYPE_COUNT, next);
+            list.items.resize(count);
+            list.itemOfCell.resize(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                std::size_t item = next[static_cast<std::size_t>(types[i])]++;
+                TileBatchItem& tile = list.items[item];
+                tile.position = TileSystem::gridToWorld(cells.cellPosition(i));
+                tile.size = glm::vec2(TileSystem::TILE_SIZE);
+                tile.isHighlighted = 0.0f;
+                tile.highlightColor = TILE_HIGHLIGHT_COLOR;
+                list.itemOfCell[i] = static_cast<std::uint32_t>(item);
+            }
+
+            shownHighlight.forEachInRect(cells.getOriginX(), cells.getOriginY(),
+                                         cells.getOriginX() + cells.getWidth(),
+                                         cells.getOriginY() + cells.getHeight(),
+                                         [&](const GridPosition& pos) {
+                list.items[list.itemOfCell[cells.cellIndex(pos)]].isHighlighted = 1.0f;
+            });
+            list.chunk = &chunk;
+            list.serial = chunk.serial;
+            list.version = cells.getVersion();
+        }
+
+        void sync(World& world) {
+            const std::uint32_t since = seenTick;
+            bool stale = syncedWorld != &world || world.getTick() <= since ||
+                         world.getLastRemovedTick<TransformComponent>() > since ||
+                         world.getLastRemovedTick<RenderableComponent>() > since;
+
+            if (!stale) {
+                world.eachChanged<TransformComponent>(since, [&](EntityID id, const TransformComponent& transform) {
+                    if (TileBatchItem* item = find(id)) {
+                        item->position = transform.position;
+                    } else if (world.hasComponent<RenderableComponent>(id)) {
+                        stale = true;
+                    }
+                });
+            }
+            if (!stale) {
+                world.eachChanged<RenderableComponent>(since, [&](EntityID id, const RenderableComponent& renderable) {
+                    TileBatchItem* item = find(id);
+                    if (!item) {
+                        stale = stale || world.hasComponent<TransformComponent>(id);
+                    } else if (textures[item - items.data()] != renderable.texture) {
+                        // Would break the texture grouping
+                        stale = true;
+                    } else {
+                        fill(*item, nullptr, renderable);
+                    }
+                });
+            }
+            if (stale) {
+                rebuild(world);
+            }
+
+            syncedWorld = &world;
+            seenTick = world.advanceTick();
+        }
+
+        TileBatchItem* find(EntityID id) {
+            std::uint32_t index = entityIndex(id);
+            if (index >= itemOf.size() || itemOf[index] == npos || owners[itemOf[index]] != id) {
+                return nullptr;
+            }
+            return &items[itemOf[index]];
+        }
+
+        static void fill(TileBatchItem& item, const TransformComponent* transform,
+                         const RenderableComponent& renderable) {
+            if (transform) {
+                item.position = transform->position;
+            }
+            item.size = renderable.size;
+            item.isHighlighted = renderable.isHighlighted ? 1.0f : 0.0f;
+            item.highlightColor = renderable.highlightColor;
+        }
+
+        void rebuild(const World& world) {
+            struct Entry {
+                EntityID id;
+                const TransformComponent* transform;
+                const RenderableComponent* renderable;
+            };
+            std::vector<Entry> entries;
+            entries.reserve(world.view<RenderableComponent>().size());
+            world.each<TransformComponent, RenderableComponent>(
+                [&](EntityID id, const TransformComponent& transform, const RenderableComponent& renderable) {
+                entries.push_back({id, &transform, &renderable});
+            });
+            std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+                return a.renderable->texture.get() < b.renderable->texture.get();
+            });
+
+            items.resize(entries.size());
+            textures.resize(entries.size());
+            owners.resize(entries.size());
+            std::fill(itemOf.begin(), itemOf.end(), npos);
+            for (std::size_t i = 0; i < entries.size(); ++i) {
+                const Entry& entry = entries[i];
+                fill(items[i], entry.transform, *entry.renderable);
+                textures[i] = entry.renderable->texture;
+                owners[i] = entry.id;
+                std::uint32_t index = entityIndex(entry.id);
+                if (index >= itemOf.size()) {
+                    itemOf.resize(static_cast<std::size_t>(index) + 1, npos);
+                }
+                itemOf[index] = static_cast<std::uint32_t>(i);
+            }
+        }
     };
 }
\ No newline at end of file
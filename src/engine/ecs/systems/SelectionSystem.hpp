@@ -1,32 +1,49 @@
 #pragma once
 #include "../World.hpp"
-#include "../components/TileComponent.hpp"
-#include "../components/RenderableComponent.hpp"
+#include "../SystemScheduler.hpp"
+#include "../CellSet.hpp"
+#include "../../../game/world/ChunkedTileMap.hpp"
 
 namespace engine {
+    // Tracks which cells are highlighted: the brush under the cursor plus an
+    // explicit multi-cell selection. The result is a CellSet that RenderSystem
+    // diffs against the previous frame, so a highlight change costs the same on
+    // any map size.
     class SelectionSystem {
     public:
-        void updateSelection(World& world, const GridPosition& hoveredPos) {
-            selectedTile = nullptr;
-            auto tiles = world.getComponents<TileComponent>();
-            
-            for (auto* tile : tiles) {
-                auto* renderable = world.getEntity(tile->getOwner())
-                    ->getComponent<RenderableComponent>();
-                
-                if (tile->gridPosition.x == hoveredPos.x && 
-                    tile->gridPosition.y == hoveredPos.y) {
-                    renderable->isHighlighted = true;
-                    selectedTile = tile;
-                } else {
-                    renderable->isHighlighted = false;
-                }
-            }
+        // Touches no components, but RenderSystem reads getHighlighted(); both
+        // are main-thread systems, so they run in registration order
+        static SystemAccess getAccess() {
+            return SystemAccess().onMainThread();
         }
 
-        const TileComponent* getSelectedTile() const { return selectedTile; }
+        void updateSelection(const game::ChunkedTileMap& map, const GridPosition& hoveredPos) {
+            highlighted = brushRadius > 0 ? CellSet::circle(hoveredPos, brushRadius)
+                                          : CellSet::cell(hoveredPos);
+            highlighted.unite(selection);
+
+            hasSelectedTile = map.getType(hoveredPos) != TileType::NONE;
+            selectedTile = hoveredPos;
+        }
+
+        // Hovered cell if it holds a loaded tile, otherwise nullptr
+        const GridPosition* getSelectedTile() const { return hasSelectedTile ? &selectedTile : nullptr; }
+
+        const CellSet& getHighlighted() const { return highlighted; }
+
+        // Radius of the circular hover brush; 0 highlights just the hovered cell
+        void setBrushRadius(int radius) { brushRadius = radius; }
+        int getBrushRadius() const { return brushRadius; }
+
+        void setSelection(CellSet cells) { selection = std::move(cells); }
+        void clearSelection() { selection.clear(); }
+        const CellSet& getSelection() const { return selection; }
 
     private:
-        TileComponent* selectedTile = nullptr;
+        GridPosition selectedTile;
+        bool hasSelectedTile = false;
+        CellSet selection;
+        CellSet highlighted;
+        int brushRadius = 0;
     };
 }
\ No newline at end of file
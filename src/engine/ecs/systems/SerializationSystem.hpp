@@ -1,7 +1,7 @@
 #pragma once
-#include "../World.hpp"
-#include "../components/TileComponent.hpp"
-#include "../components/RenderableComponent.hpp"
+#include "../../core/ResourceCache.hpp"
+#include "../../../game/world/ChunkStreamer.hpp"
+#include "TileSystem.hpp"
 #include <fstream>
 #include <vector>
 #include <unordered_map>
@@ -35,7 +35,10 @@ namespace engine {
             }
         }
 
-        bool saveMap(const World& world, const std::string& filename) {
+        // Сохраняет карту целиком, включая выгруженные чанки: streamer
+        // поочерёдно отдаёт каждый чанк из памяти, дискового кэша или генератора
+        bool saveMap(game::ChunkStreamer& streamer, const std::string& filename) {
+            const game::ChunkedTileMap& map = streamer.getMap();
             fs::path fullPath = savePath / filename;
             std::ofstream file(fullPath, std::ios::binary);
         
@@ -44,11 +47,8 @@ namespace engine {
                 return false;
             }
             
-            // Получаем тайлы
-            auto tiles = world.getComponents<TileComponent>();
-            
             // Проверяем, есть ли тайлы для сохранения
-            if (tiles.empty()) {
+            if (map.getWidth() == 0 || map.getHeight() == 0) {
                 std::cerr << "No tiles to save" << std::endl;
                 return false;
             }
@@ -57,27 +57,35 @@ namespace engine {
             MapHeader header{
                 0x434F4C53,  // SLOC в ASCII
                 1,           // Версия 1
-                64, 64,      // Размеры карты
+                static_cast<uint32_t>(map.getWidth()),   // Размеры карты
+                static_cast<uint32_t>(map.getHeight()),
             };
             // Записываем заголовок
             file.write(reinterpret_cast<const char*>(&header), sizeof(header));
 
-            // Записываем данные тайлов
-            for (const auto* tile : tiles) {
-                TileRecord record;
+            // Записываем данные тайлов (пустые клетки пропускаем)
+            streamer.visitAllChunks([&](const game::TileLayer& cells) {
+                const TileType* types = cells.typeData();
+                const uint8_t* walkable = cells.walkableData();
+                for (std::size_t i = 0, n = cells.getCellCount(); i < n; ++i) {
+                    if (types[i] == TileType::NONE) continue;
 
-                record.x = tile->gridPosition.x;
-                record.y = tile->gridPosition.y;
-                record.type = static_cast<uint8_t>(tile->type);
-                record.walkable = tile->walkable ? 1 : 0;
+                    GridPosition pos = cells.cellPosition(i);
+                    TileRecord record;
 
-                file.write(reinterpret_cast<const char*>(&record), sizeof(record));
-            }
+                    record.x = static_cast<uint32_t>(pos.x);
+                    record.y = static_cast<uint32_t>(pos.y);
+                    record.type = static_cast<uint8_t>(types[i]);
+                    record.walkable = walkable[i];
+
+                    file.write(reinterpret_cast<const char*>(&record), sizeof(record));
+                }
+            });
             
             return true;
         }
 
-        bool loadMap(World& world, const std::string& filename, 
+        bool loadMap(game::ChunkedTileMap& map, const std::string& filename, 
                     ResourceCache& resourceCache, TileSystem& tileSystem) {
             fs::path fullPath = savePath / filename;
             
@@ -107,52 +115,32 @@ namespace engine {
                 return false;
             }
 
-            // Очищаем текущий мир
-            world = World();
+            // Читаем все записи, затем создаем тайлы одним пакетом
+            std::vector<GridPosition> positions;
+            std::vector<const TileData*> tileData;
+            // TileData на каждую пару (тип, проходимость) - текстура ищется один раз на тип
+            std::unordered_map<uint32_t, TileData> dataCache;
 
-            // Читаем и создаем тайлы
             TileRecord record;
-            bool tilesLoaded = false;
-
             while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
-                TileData data;
-                data.type = static_cast<TileType>(record.type);
-                data.walkable = record.walkable != 0;
-
-                std::string texturePath;
-                switch(data.type) {
-                    case TileType::WATER:
-                        texturePath = "tiles/water/sea_water.png";
-                        break;
-                    case TileType::SAND:
-                        texturePath = "tiles/ground/sand.png";
-                        break;
-                    case TileType::GRASS:
-                        texturePath = "tiles/ground/grass.png";
-                        break;
-                    case TileType::SNOW:
-                        texturePath = "tiles/ground/snow.png";
-                        break;
-                    case TileType::FOREST:
-                        texturePath = "tiles/ground/forest.png";
-                        break;
-                    case TileType::MOUNTAIN:
-                        texturePath = "tiles/ground/mountain.png";
-                        break;
-                    case TileType::DIRT:
-                        texturePath = "tiles/ground/dirt.png";
-                        break;
-                    default:
-                        texturePath = "tiles/ground/stone_ground.png";
+                uint32_t key = (uint32_t(record.type) << 1) | (record.walkable != 0 ? 1u : 0u);
+                auto it = dataCache.find(key);
+                if (it == dataCache.end()) {
+                    TileData data;
+                    data.type = static_cast<TileType>(record.type);
+                    data.walkable = record.walkable != 0;
+                    data.texture = resourceCache.getTexture(getTexturePath(data.type));
+                    it = dataCache.emplace(key, std::move(data)).first;
                 }
-                
-                data.texture = resourceCache.getTexture(texturePath);
-                
-                GridPosition pos{static_cast<int>(record.x), static_cast<int>(record.y)};
-                tileSystem.createTile(world, data, pos);
-                tilesLoaded = true;
+
+                positions.emplace_back(static_cast<int>(record.x), static_cast<int>(record.y));
+                tileData.push_back(&it->second);
             }
 
+            // Карта заново размечается по границам загруженных клеток
+            tileSystem.createTiles(map, positions, tileData);
+            bool tilesLoaded = !positions.empty();
+
             if (!tilesLoaded) {
                 std::cerr << "No tiles loaded from save file" << std::endl;
                 return false;
@@ -162,5 +150,26 @@ namespace engine {
         }
     private:
         fs::path savePath;
+
+        static const char* getTexturePath(TileType type) {
+            switch(type) {
+                case TileType::WATER:
+                    return "tiles/water/sea_water.png";
+                case TileType::SAND:
+                    return "tiles/ground/sand.png";
+                case TileType::GRASS:
+                    return "tiles/ground/grass.png";
+                case TileType::SNOW:
+                    return "tiles/ground/snow.png";
+                case TileType::FOREST:
+                    return "tiles/ground/forest.png";
+                case TileType::MOUNTAIN:
+                    return "tiles/ground/mountain.png";
+                case TileType::DIRT:
+                    return "tiles/ground/dirt.png";
+                default:
+                    return "tiles/ground/stone_ground.png";
+            }
+        }
     };
 }
\ No newline at end of file
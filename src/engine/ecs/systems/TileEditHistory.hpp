@@ -0,0 +1,237 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "../../../game/world/ChunkedTileMap.hpp"
+
+namespace engine {
+    // Bounding box of the cells changed by one edit (corners inclusive)
+    struct TileRegion {
+        GridPosition min{INT_MAX, INT_MAX};
+        GridPosition max{INT_MIN, INT_MIN};
+        std::size_t changedCells = 0;
+
+        bool empty() const { return changedCells == 0; }
+
+        void add(const GridPosition& pos) {
+            min = GridPosition(std::min(min.x, pos.x), std::min(min.y, pos.y));
+            max = GridPosition(std::max(max.x, pos.x), std::max(max.y, pos.y));
+            ++changedCells;
+        }
+    };
+
+    // Undo/redo journal for TileEditSystem. An edit writes one new (type,
+    // walkable) pair to many cells, so only the old values are kept, as runs
+    // of consecutive cell indices per chunk that had the same old value. A
+    // brush stroke costs a few bytes per row it touched rather than per cell,
+    // and the whole journal stays under a byte limit by dropping the oldest
+    // edits.
+    class TileEditHistory {
+    public:
+        // Returns the chunk, loading it if needed; nullptr if it cannot exist
+        using ChunkLoader = std::function<game::TileChunk*(int chunkX, int chunkY)>;
+
+        static constexpr std::size_t DEFAULT_MEMORY_LIMIT = 16 * 1024 * 1024;
+
+        // Edits committed between beginGroup() and endGroup() (e.g. one brush
+        // stroke) are undone and redone together
+        void beginGroup() {
+            ++nextGroup;
+            grouping = true;
+        }
+        void endGroup() { grouping = false; }
+
+        // Starts recording an edit that writes newType/newWalkable
+        void begin(TileType newType, bool newWalkable) {
+            pending = Edit();
+            pending.group = grouping ? nextGroup : ++nextGroup;
+            pending.newType = newType;
+            pending.newWalkable = newWalkable ? 1 : 0;
+            pendingChunk = nullptr;
+            pendingChunkOf.clear();
+        }
+
+        // Cells of one chunk must be recorded in increasing index order
+        void record(const game::TileChunk& chunk, std::size_t index, TileType oldType, std::uint8_t oldWalkable) {
+            if (!pendingChunk || pendingChunk->chunkX != chunk.chunkX || pendingChunk->chunkY != chunk.chunkY) {
+                auto [it, inserted] = pendingChunkOf.emplace(game::ChunkedTileMap::chunkKey(chunk.chunkX, chunk.chunkY), pending.chunks.size());
+                if (inserted) {
+                    pending.chunks.push_back({chunk.chunkX, chunk.chunkY, {}});
+                }
+                pendingChunk = &pending.chunks[it->second];
+            }
+            std::vector<Run>& runs = pendingChunk->runs;
+            if (!runs.empty()) {
+                Run& last = runs.back();
+                if (last.start + last.length == index && last.oldType == oldType &&
+                    last.oldWalkable == oldWalkable && last.length < UINT16_MAX) {
+                    ++last.length;
+                    return;
+                }
+            }
+            runs.push_back({static_cast<std::uint16_t>(index), 1, oldType, oldWalkable});
+        }
+
+        // Finishes the edit started by begin(). An edit larger than the whole
+        // limit cannot be undone and clears the journal instead
+        void commit() {
+            pendingChunk = nullptr;
+            pendingChunkOf.clear();
+            if (pending.chunks.empty()) return;
+
+            clearRedo();
+            pending.bytes = sizeof(Edit);
+            for (ChunkDiff& diff : pending.chunks) {
+                diff.runs.shrink_to_fit();
+                pending.bytes += sizeof(ChunkDiff) + diff.runs.size() * sizeof(Run);
+            }
+            if (pending.bytes > memoryLimit) {
+                clear();
+                return;
+            }
+            memoryUsage += pending.bytes;
+            undoStack.push_back(std::move(pending));
+            trim();
+        }
+
+        // Restores the cells of the last edit (or group); false if there is
+        // none or one of its chunks could not be loaded
+        bool undo(const ChunkLoader& load, TileRegion& region) {
+            return step(undoStack, redoStack, load, false, region);
+        }
+
+        bool redo(const ChunkLoader& load, TileRegion& region) {
+            return step(redoStack, undoStack, load, true, region);
+        }
+
+        void clear() {
+            undoStack.clear();
+            redoStack.clear();
+            memoryUsage = 0;
+        }
+
+        bool canUndo() const { return !undoStack.empty(); }
+        bool canRedo() const { return !redoStack.empty(); }
+        std::size_t getUndoCount() const { return undoStack.size(); }
+        std::size_t getRedoCount() const { return redoStack.size(); }
+        std::size_t getMemoryUsage() const { return memoryUsage; }
+
+        void setMemoryLimit(std::size_t bytes) {
+            memoryLimit = bytes;
+            trim();
+        }
+        std::size_t getMemoryLimit() const { return memoryLimit; }
+
+    private:
+        struct Run {
+            std::uint16_t start;
+            std::uint16_t length;
+            TileType oldType;
+            std::uint8_t oldWalkable;
+        };
+
+        struct ChunkDiff {
+            int chunkX;
+            int chunkY;
+            std::vector<Run> runs;
+        };
+
+        struct Edit {
+            std::uint64_t group = 0;
+            TileType newType = TileType::NONE;
+            std::uint8_t newWalkable = 0;
+            std::vector<ChunkDiff> chunks;
+            std::size_t bytes = 0;
+        };
+
+        std::deque<Edit> undoStack;
+        std::deque<Edit> redoStack;
+        std::size_t memoryUsage = 0;
+        std::size_t memoryLimit = DEFAULT_MEMORY_LIMIT;
+        std::uint64_t nextGroup = 0;
+        bool grouping = false;
+
+        Edit pending;
+        ChunkDiff* pendingChunk = nullptr;
+        std::unordered_map<std::uint64_t, std::size_t> pendingChunkOf;
+
+        void clearRedo() {
+            for (const Edit& edit : redoStack) {
+                memoryUsage -= edit.bytes;
+            }
+            redoStack.clear();
+        }
+
+        // Drops whole groups from the far end of each stack
+        void trim() {
+            for (std::deque<Edit>* stack : {&redoStack, &undoStack}) {
+                while (memoryUsage > memoryLimit && !stack->empty()) {
+                    std::uint64_t group = stack->front().group;
+                    while (!stack->empty() && stack->front().group == group) {
+                        memoryUsage -= stack->front().bytes;
+                        stack->pop_front();
+                    }
+                }
+            }
+        }
+
+        // Applies the group on top of `from` newest first and moves it to `to`.
+        // All chunks of the group are loaded before anything is written, so a
+        // failed load leaves the group whole on `from`
+        bool step(std::deque<Edit>& from, std::deque<Edit>& to, const ChunkLoader& load,
+                  bool forward, TileRegion& region) {
+            if (from.empty()) return false;
+            std::uint64_t group = from.back().group;
+            std::size_t count = 0;
+            while (count < from.size() && from[from.size() - 1 - count].group == group) {
+                ++count;
+            }
+
+            std::vector<std::vector<game::TileChunk*>> chunks(count);
+            for (std::size_t e = 0; e < count; ++e) {
+                if (!resolve(from[from.size() - 1 - e], load, chunks[e])) return false;
+            }
+            for (std::size_t e = 0; e < count; ++e) {
+                apply(from.back(), chunks[e], forward, region);
+                to.push_back(std::move(from.back()));
+                from.pop_back();
+            }
+            return true;
+        }
+
+        static bool resolve(const Edit& edit, const ChunkLoader& load, std::vector<game::TileChunk*>& chunks) {
+            chunks.reserve(edit.chunks.size());
+            for (const ChunkDiff& diff : edit.chunks) {
+                game::TileChunk* chunk = load(diff.chunkX, diff.chunkY);
+                if (!chunk) return false;
+                chunks.push_back(chunk);
+            }
+            return true;
+        }
+
+        static void apply(const Edit& edit, const std::vector<game::TileChunk*>& chunks, bool forward,
+                          TileRegion& region) {
+            for (std::size_t c = 0; c < chunks.size(); ++c) {
+                game::TileLayer& cells = chunks[c]->cells;
+                TileType* types = cells.typeData();
+                std::uint8_t* walkable = cells.walkableData();
+                for (const Run& run : edit.chunks[c].runs) {
+                    TileType type = forward ? edit.newType : run.oldType;
+                    std::uint8_t walkableValue = forward ? edit.newWalkable : run.oldWalkable;
+                    for (std::size_t i = run.start, end = std::size_t(run.start) + run.length; i < end; ++i) {
+                        types[i] = type;
+                        walkable[i] = walkableValue;
+                        chunks[c]->bits.updateCell(cells, i);
+                        region.add(cells.cellPosition(i));
+                    }
+                }
+                cells.markChanged();
+                chunks[c]->dirty = true;
+            }
+        }
+    };
+}
@@ -1,23 +1,245 @@
 #pragma once
-#include "../World.hpp"
-#include "../components/TileComponent.hpp"
-#include "../components/RenderableComponent.hpp"
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include "../CellSet.hpp"
+#include "TileEditHistory.hpp"
+#include "../../../game/world/ChunkedTileMap.hpp"
 
 namespace engine {
+    // Edits tile types on the chunked map. Every operation writes straight into
+    // the chunk arrays span by span, bumps each touched chunk's version once,
+    // marks it dirty for the disk cache and reports one TileRegion to the edit
+    // listeners, however many cells it changed. Cells that hold no tile (empty
+    // or in chunks that are not loaded) are never edited.
+    //
+    // Every edit is journaled in a TileEditHistory and can be undone; undo and
+    // redo notify the listeners like any other edit.
     class TileEditSystem {
     public:
-        void changeTileType(World& world, Entity* entity, TileType newType, 
+        using EditListener = std::function<void(const TileRegion&)>;
+
+        // Called once per edit that changed at least one cell
+        void addEditListener(EditListener listener) { listeners.push_back(std::move(listener)); }
+
+        // load brings back chunks evicted since the edit; without it only
+        // resident chunks can be restored
+        bool undo(game::ChunkedTileMap& map, const TileEditHistory::ChunkLoader& load = {}) {
+            TileRegion region;
+            if (!history.undo(loaderFor(map, load), region)) return false;
+            notify(region);
+            return true;
+        }
+
+        bool redo(game::ChunkedTileMap& map, const TileEditHistory::ChunkLoader& load = {}) {
+            TileRegion region;
+            if (!history.redo(loaderFor(map, load), region)) return false;
+            notify(region);
+            return true;
+        }
+
+        // Must be cleared when the map is replaced (regeneration, loading)
+        TileEditHistory& getHistory() { return history; }
+        const TileEditHistory& getHistory() const { return history; }
+
+        TileRegion changeTileType(game::ChunkedTileMap& map, const GridPosition& pos, TileType newType,
+                        const std::shared_ptr<Texture>& texture) {
+            return fillCells(map, CellSet::cell(pos), newType, texture);
+        }
+
+        // Corners are inclusive and may be given in any order
+        TileRegion fillRectangle(game::ChunkedTileMap& map, const GridPosition& a, const GridPosition& b,
+                        TileType newType, const std::shared_ptr<Texture>& texture) {
+            return fillCells(map, CellSet::rectangle(a, b), newType, texture);
+        }
+
+        TileRegion paintCircle(game::ChunkedTileMap& map, const GridPosition& center, int radius,
+                        TileType newType, const std::shared_ptr<Texture>& texture) {
+            return fillCells(map, CellSet::circle(center, radius), newType, texture);
+        }
+
+        TileRegion drawLine(game::ChunkedTileMap& map, const GridPosition& from, const GridPosition& to,
+                        TileType newType, const std::shared_ptr<Texture>& texture) {
+            return fillCells(map, CellSet::line(from, to), newType, texture);
+        }
+
+        // Replaces the 4-connected area of start's type that contains start,
+        // without leaving [boundsMin, boundsMax]
+        TileRegion floodFill(game::ChunkedTileMap& map, const GridPosition& start, TileType newType,
+                        const GridPosition& boundsMin, const GridPosition& boundsMax,
+                        const std::shared_ptr<Texture>& texture) {
+            return fillCells(map, floodArea(map, start, boundsMin, boundsMax), newType, texture);
+        }
+
+        // Any set of cells, e.g. the current selection
+        TileRegion fillCells(game::ChunkedTileMap& map, const CellSet& cells, TileType newType,
+                        const std::shared_ptr<Texture>& texture) {
+            const std::uint8_t walkableValue = isWalkableType(newType) ? 1 : 0;
+            TileRegion region;
+            game::TileChunk* chunk = nullptr;
+            bool chunkChanged = false;
+            history.begin(newType, walkableValue != 0);
+
+            for (const CellSet::Span& span : cells.getSpans()) {
+                // Row span cut at chunk borders; consecutive spans usually stay
+                // in the same chunk, so the hash lookup is mostly skipped
+                for (int x = span.x0; x < span.x1;) {
+                    GridPosition pos(x, span.y);
+                    auto coord = game::ChunkedTileMap::chunkOf(pos);
+                    int segmentEnd = std::min(span.x1, (coord.x + 1) * game::ChunkedTileMap::CHUNK_SIZE);
+                    if (!chunk || chunk->chunkX != coord.x || chunk->chunkY != coord.y) {
+                        finishChunk(chunk, chunkChanged);
+                        chunk = map.findChunk(coord.x, coord.y);
+                    }
+                    if (chunk) {
+                        game::TileLayer& layer = chunk->cells;
+                        TileType* types = layer.typeData();
+                        std::uint8_t* walkable = layer.walkableData();
+                        for (; x < segmentEnd; ++x) {
+                            pos.x = x;
+                            if (!map.contains(pos)) continue;
+                            std::size_t index = layer.cellIndex(pos);
+                            if (types[index] == TileType::NONE || types[index] == newType) continue;
+                            history.record(*chunk, index, types[index], walkable[index]);
+                            types[index] = newType;
+                            walkable[index] = walkableValue;
+                            chunk->bits.updateCell(layer, index);
+                            chunkChanged = true;
+                            region.add(pos);
+                        }
+                    }
+                    x = segmentEnd;
+                }
+            }
+            finishChunk(chunk, chunkChanged);
+            finishEdit(map, region, newType, texture);
+            return region;
+        }
+
+        // Replaces every tile of type `from` in the loaded chunks, one pass over
+        // each chunk's type array. Chunks that are not resident are untouched.
+        TileRegion replaceTileType(game::ChunkedTileMap& map, TileType from, TileType to,
                         const std::shared_ptr<Texture>& texture) {
-            if (!entity) return;
-            
-            // Remove const to modify components
-            auto* tile = const_cast<TileComponent*>(entity->getComponent<TileComponent>());
-            auto* renderable = const_cast<RenderableComponent*>(entity->getComponent<RenderableComponent>());
-            if (tile && renderable) {
-                tile->type = newType;
-                tile->walkable = (newType == TileType::GROUND);
-                renderable->texture = texture;
+            const std::uint8_t walkableValue = isWalkableType(to) ? 1 : 0;
+            TileRegion region;
+            history.begin(to, walkableValue != 0);
+            map.forEachChunk([&](game::TileChunk& chunk) {
+                game::TileLayer& cells = chunk.cells;
+                TileType* types = cells.typeData();
+                std::uint8_t* walkable = cells.walkableData();
+                bool changed = false;
+                for (std::size_t i = 0, n = cells.getCellCount(); i < n; ++i) {
+                    if (types[i] == from && from != to) {
+                        history.record(chunk, i, types[i], walkable[i]);
+                        types[i] = to;
+                        walkable[i] = walkableValue;
+                        chunk.bits.updateCell(cells, i);
+                        changed = true;
+                        region.add(cells.cellPosition(i));
+                    }
+                }
+                finishChunk(&chunk, changed);
+            });
+            finishEdit(map, region, to, texture);
+            return region;
+        }
+
+    private:
+        std::vector<EditListener> listeners;
+        TileEditHistory history;
+
+        static bool isWalkableType(TileType type) { return type == TileType::GROUND; }
+
+        static void finishChunk(game::TileChunk* chunk, bool& changed) {
+            if (chunk && changed) {
+                chunk->cells.markChanged();
+                chunk->dirty = true;
+            }
+            changed = false;
+        }
+
+        void finishEdit(game::ChunkedTileMap& map, const TileRegion& region, TileType type,
+                        const std::shared_ptr<Texture>& texture) {
+            history.commit();
+            if (texture) {
+                map.setTexture(type, texture);
+            }
+            notify(region);
+        }
+
+        void notify(const TileRegion& region) {
+            if (region.empty()) return;
+            for (const auto& listener : listeners) {
+                listener(region);
+            }
+        }
+
+        static TileEditHistory::ChunkLoader loaderFor(game::ChunkedTileMap& map,
+                                                      const TileEditHistory::ChunkLoader& load) {
+            if (load) return load;
+            return [&map](int chunkX, int chunkY) { return map.findChunk(chunkX, chunkY); };
+        }
+
+        // Scanline fill over a bitmap of the bounds; rows come out in order, so
+        // the result is built with appends only
+        static CellSet floodArea(const game::ChunkedTileMap& map, const GridPosition& start,
+                                 GridPosition boundsMin, GridPosition boundsMax) {
+            CellSet area;
+            boundsMin = GridPosition(std::max(boundsMin.x, map.getOriginX()), std::max(boundsMin.y, map.getOriginY()));
+            boundsMax = GridPosition(std::min(boundsMax.x, map.getOriginX() + map.getWidth() - 1),
+                                     std::min(boundsMax.y, map.getOriginY() + map.getHeight() - 1));
+            if (start.x < boundsMin.x || start.y < boundsMin.y || start.x > boundsMax.x || start.y > boundsMax.y) {
+                return area;
+            }
+            const TileType target = map.getType(start);
+            if (target == TileType::NONE) return area;
+
+            const int width = boundsMax.x - boundsMin.x + 1;
+            const int height = boundsMax.y - boundsMin.y + 1;
+            std::vector<std::uint8_t> filled(static_cast<std::size_t>(width) * height, 0);
+            auto matches = [&](int x, int y) {
+                std::size_t bit = static_cast<std::size_t>(y - boundsMin.y) * width + (x - boundsMin.x);
+                return !filled[bit] && map.getType(GridPosition(x, y)) == target;
+            };
+
+            std::vector<GridPosition> stack{start};
+            while (!stack.empty()) {
+                GridPosition seed = stack.back();
+                stack.pop_back();
+                if (!matches(seed.x, seed.y)) continue;
+
+                int x0 = seed.x, x1 = seed.x;
+                while (x0 > boundsMin.x && matches(x0 - 1, seed.y)) --x0;
+                while (x1 < boundsMax.x && matches(x1 + 1, seed.y)) ++x1;
+                std::uint8_t* row = &filled[static_cast<std::size_t>(seed.y - boundsMin.y) * width];
+                std::fill(row + (x0 - boundsMin.x), row + (x1 - boundsMin.x) + 1, 1);
+
+                for (int y : {seed.y - 1, seed.y + 1}) {
+                    if (y < boundsMin.y || y > boundsMax.y) continue;
+                    bool inRun = false;
+                    for (int x = x0; x <= x1; ++x) {
+                        bool match = matches(x, y);
+                        if (match && !inRun) {
+                            stack.emplace_back(x, y);
+                        }
+                        inRun = match;
+                    }
+                }
+            }
+
+            for (int y = 0; y < height; ++y) {
+                const std::uint8_t* row = &filled[static_cast<std::size_t>(y) * width];
+                for (int x = 0; x < width;) {
+                    if (!row[x]) {
+                        ++x;
+                        continue;
+                    }
+                    int runStart = x;
+                    while (x < width && row[x]) ++x;
+                    area.addSpan(boundsMin.y + y, boundsMin.x + runStart, boundsMin.x + x);
+                }
             }
+            return area;
         }
     };
-}
\ No newline at end of file
+}
@@ -1,34 +1,73 @@
 #pragma once
-#include "../World.hpp"
-#include "../components/TileComponent.hpp"
-#include "../components/TransformComponent.hpp"
-#include "../components/RenderableComponent.hpp"
-#include "../../../game/world/ExtendedTileComponent.hpp"
+#include "../../../game/world/ChunkedTileMap.hpp"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <climits>
 
 namespace engine {
+    // Fills the chunked tile map and converts between grid and world
+    // coordinates. Tiles are cells of game::TileChunk layers, not entities; a
+    // lookup by GridPosition is a chunk hash lookup plus an index computation.
     class TileSystem {
     public:
-        Entity* createTile(World& world, const TileData& data, const GridPosition& pos) {
-            Entity* entity = world.createEntity();
-            
-            auto* tile = entity->addComponent<TileComponent>(data.type, data.walkable, pos);
-            auto* transform = entity->addComponent<TransformComponent>();
-            auto* renderable = entity->addComponent<RenderableComponent>();
+        // False if pos lies outside the map or its chunk is not loaded
+        bool createTile(game::ChunkedTileMap& map, const TileData& data, const GridPosition& pos) {
+            std::size_t index;
+            game::TileChunk* chunk = map.findCell(pos, index);
+            if (!chunk) return false;
+            chunk->cells.setTile(index, data);
+            chunk->bits.updateCell(chunk->cells, index);
+            chunk->dirty = true;
+            if (data.texture) {
+                map.setTexture(data.type, data.texture);
+            }
+            return true;
+        }
 
-            transform->position = gridToWorld(pos);
-            renderable->texture = data.texture;
-            renderable->size = glm::vec2(TILE_SIZE);
+        // Batch version of createTile: resets the map to the bounds of
+        // `positions` (so any rectangular map shape works), creates the chunks
+        // they touch and fills cell i from *data[i]. The chunks are marked dirty,
+        // so the streamer writes them to its disk cache before evicting them.
+        // finishTile(i, cells, cellIndex) lets the caller set extra per-cell
+        // fields in the same pass.
+        template<typename Func>
+        void createTiles(game::ChunkedTileMap& map, const std::vector<GridPosition>& positions,
+                        const std::vector<const TileData*>& data, Func&& finishTile) {
+            if (positions.empty()) {
+                map.reset(0, 0);
+                return;
+            }
+            int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+            for (const auto& pos : positions) {
+                minX = std::min(minX, pos.x);
+                minY = std::min(minY, pos.y);
+                maxX = std::max(maxX, pos.x);
+                maxY = std::max(maxY, pos.y);
+            }
+            map.reset(maxX - minX + 1, maxY - minY + 1, minX, minY);
 
-            auto* extTile = entity->addComponent<game::ExtendedTileComponent>();
-            extTile->type = data.type;
-            extTile->properties.walkable = data.walkable;
-            extTile->properties.buildable = data.buildable;
-            extTile->properties.elevation = data.elevation;
-            extTile->properties.fertility = data.fertility;
-            extTile->properties.humidity = data.humidity;
-            extTile->properties.temperature = data.temperature;
+            for (std::size_t i = 0; i < positions.size(); ++i) {
+                auto coord = game::ChunkedTileMap::chunkOf(positions[i]);
+                game::TileChunk* chunk = map.findChunk(coord.x, coord.y);
+                if (!chunk) {
+                    chunk = &map.insertChunk(game::ChunkedTileMap::makeChunk(coord.x, coord.y));
+                    chunk->dirty = true;
+                }
+                std::size_t index = chunk->cells.cellIndex(positions[i]);
+                chunk->cells.setTile(index, *data[i]);
+                if (data[i]->texture && map.getTexture(data[i]->type) != data[i]->texture) {
+                    map.setTexture(data[i]->type, data[i]->texture);
+                }
+                finishTile(i, chunk->cells, index);
+                chunk->bits.updateCell(chunk->cells, index);
+            }
+        }
 
-            return entity;
+        void createTiles(game::ChunkedTileMap& map, const std::vector<GridPosition>& positions,
+                        const std::vector<const TileData*>& data) {
+            createTiles(map, positions, data, [](std::size_t, game::TileLayer&, std::size_t) {});
         }
 
         static glm::vec2 gridToWorld(const GridPosition& pos) {
@@ -41,7 +80,7 @@ namespace engine {
                 static_cast<int>(std::floor(worldPos.y / TILE_SIZE))
             };
         }
-    private:
+
         static constexpr float TILE_SIZE = 1.0f;
     };
 }
\ No newline at end of file
@@ -1,9 +1,11 @@
 #pragma once
 #include <memory>
+#include <cstddef>
+#include <cstdint>
 #include "../engine/rendering/Texture.hpp"
 
 // Перечисление для типов тайлов
-enum class TileType {
+enum class TileType : std::uint8_t {
     NONE,           // Пустой/недоступный тайл
     GROUND,         // Обычная земля
     WATER,          // Вода
@@ -16,6 +18,9 @@ enum class TileType {
     // Добавим другие типы позже
 };
 
+// Количество типов тайлов (для таблиц, индексируемых типом)
+constexpr std::size_t TILE_TYPE_COUNT = static_cast<std::size_t>(TileType::FOREST) + 1;
+
 // Структура для хранения данных о тайле
 struct TileData {
     TileType type = TileType::GROUND;               // Тип тайла
@@ -1,7 +1,9 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 
 namespace game {
-    enum class BiomeType {
+    enum class BiomeType : std::uint8_t {
         TEMPERATE,    // Умеренный
         DESERT,       // Пустыня
         TUNDRA,       // Тундра
@@ -11,4 +13,6 @@ namespace game {
         MOUNTAIN,     // Горы
         ICE_SHEET     // Ледник
     };
+
+    constexpr std::size_t BIOME_TYPE_COUNT = static_cast<std::size_t>(BiomeType::ICE_SHEET) + 1;
 }
\ No newline at end of file
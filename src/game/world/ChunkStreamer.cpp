@@ -0,0 +1,322 @@
+#include "ChunkStreamer.hpp"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace game {
+
+namespace {
+    constexpr std::uint32_t CHUNK_FILE_MAGIC = 0x4B4E4843;  // CHNK в ASCII
+    constexpr std::uint32_t CHUNK_FILE_VERSION = 1;
+
+    struct ChunkFileHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::int32_t chunkX;
+        std::int32_t chunkY;
+        std::uint32_t cellCount;
+    };
+
+    template<typename T>
+    void writeArray(std::ofstream& file, const T* data, std::size_t count) {
+        file.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    }
+
+    template<typename T>
+    bool readArray(std::ifstream& file, T* data, std::size_t count) {
+        return static_cast<bool>(file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T))));
+    }
+}
+
+ChunkStreamer::ChunkStreamer(ChunkedTileMap& map, engine::ThreadPool& threadPool, Settings settings)
+    : map(map), threadPool(threadPool), settings(std::move(settings)) {
+}
+
+ChunkStreamer::~ChunkStreamer() {
+    // Задачи ссылаются на this, поэтому дожидаемся их, но карту уже не трогаем
+    for (auto& [key, load] : pendingLoads) {
+        load.wait();
+    }
+    for (auto& [key, write] : pendingWrites) {
+        write.wait();
+    }
+}
+
+void ChunkStreamer::reset(const LocalMapGenerator* generator) {
+    for (auto& [key, load] : pendingLoads) {
+        load.wait();
+    }
+    pendingLoads.clear();
+    for (auto& [key, write] : pendingWrites) {
+        write.wait();
+    }
+    pendingWrites.clear();
+    failedChunks.clear();
+
+    std::error_code error;
+    std::filesystem::remove_all(settings.cacheDir, error);
+
+    this->generator = generator;
+    frame = 0;
+}
+
+void ChunkStreamer::update(const GridPosition& viewMin, const GridPosition& viewMax) {
+    ++frame;
+    collectFinished(false);
+    if (map.getWidth() == 0 || map.getHeight() == 0) return;
+
+    // Нужная область в чанках, обрезанная границами карты
+    auto first = ChunkedTileMap::chunkOf(GridPosition(map.getOriginX(), map.getOriginY()));
+    auto last = ChunkedTileMap::chunkOf(GridPosition(map.getOriginX() + map.getWidth() - 1,
+                                                     map.getOriginY() + map.getHeight() - 1));
+    auto low = ChunkedTileMap::chunkOf(GridPosition(std::min(viewMin.x, viewMax.x), std::min(viewMin.y, viewMax.y)));
+    auto high = ChunkedTileMap::chunkOf(GridPosition(std::max(viewMin.x, viewMax.x), std::max(viewMin.y, viewMax.y)));
+    int minX = std::max(low.x - settings.preloadMargin, first.x);
+    int minY = std::max(low.y - settings.preloadMargin, first.y);
+    int maxX = std::min(high.x + settings.preloadMargin, last.x);
+    int maxY = std::min(high.y + settings.preloadMargin, last.y);
+
+    const std::size_t budgetChunks = std::max<std::size_t>(1, settings.memoryBudget / CHUNK_BYTES);
+    std::size_t wantedResident = 0;
+    struct Missing {
+        long long distance;
+        int chunkX;
+        int chunkY;
+    };
+    std::vector<Missing> missing;
+    const int centerX = (minX + maxX) / 2, centerY = (minY + maxY) / 2;
+    for (int chunkY = minY; chunkY <= maxY; ++chunkY) {
+        for (int chunkX = minX; chunkX <= maxX; ++chunkX) {
+            if (TileChunk* chunk = map.findChunk(chunkX, chunkY)) {
+                chunk->lastUsed = frame;
+                ++wantedResident;
+            } else if (pendingLoads.find(ChunkedTileMap::chunkKey(chunkX, chunkY)) == pendingLoads.end() &&
+                       failedChunks.find(ChunkedTileMap::chunkKey(chunkX, chunkY)) == failedChunks.end()) {
+                long long dx = chunkX - centerX, dy = chunkY - centerY;
+                missing.push_back({dx * dx + dy * dy, chunkX, chunkY});
+            }
+        }
+    }
+
+    // Ближайшие к центру обзора - первыми; бюджет не превышаем даже если
+    // область обзора в него не помещается
+    std::sort(missing.begin(), missing.end(), [](const Missing& a, const Missing& b) {
+        return a.distance < b.distance;
+    });
+    std::size_t submitted = 0;
+    for (const Missing& request : missing) {
+        if (submitted >= settings.maxRequestsPerUpdate ||
+            wantedResident + pendingLoads.size() >= budgetChunks) {
+            break;
+        }
+        std::uint64_t chunkKey = ChunkedTileMap::chunkKey(request.chunkX, request.chunkY);
+        // Чанк ещё записывается на диск - читаем его после записи
+        auto write = pendingWrites.find(chunkKey);
+        if (write != pendingWrites.end()) {
+            if (!engine::isReady(write->second)) continue;
+            write->second.get();
+            pendingWrites.erase(write);
+        }
+        int chunkX = request.chunkX, chunkY = request.chunkY;
+        pendingLoads.emplace(chunkKey, threadPool.submit([this, chunkX, chunkY]() {
+            return loadOrGenerate(chunkX, chunkY);
+        }));
+        ++submitted;
+    }
+
+    evict(minX, minY, maxX, maxY);
+}
+
+void ChunkStreamer::flush() {
+    collectFinished(true);
+}
+
+TileChunk* ChunkStreamer::acquireChunk(int chunkX, int chunkY) {
+    if (!map.containsChunk(chunkX, chunkY)) return nullptr;
+    if (TileChunk* chunk = map.findChunk(chunkX, chunkY)) {
+        chunk->lastUsed = frame;
+        return chunk;
+    }
+
+    std::uint64_t chunkKey = ChunkedTileMap::chunkKey(chunkX, chunkY);
+    if (failedChunks.find(chunkKey) != failedChunks.end()) return nullptr;
+    std::unique_ptr<TileChunk> chunk;
+    auto load = pendingLoads.find(chunkKey);
+    if (load != pendingLoads.end()) {
+        chunk = load->second.get();
+        pendingLoads.erase(load);
+    } else {
+        auto write = pendingWrites.find(chunkKey);
+        if (write != pendingWrites.end()) {
+            write->second.get();
+            pendingWrites.erase(write);
+        }
+        chunk = loadOrGenerate(chunkX, chunkY);
+    }
+    if (!chunk) {
+        failedChunks.insert(chunkKey);
+        return nullptr;
+    }
+    chunk->lastUsed = frame;
+    return &map.insertChunk(std::move(chunk));
+}
+
+void ChunkStreamer::visitAllChunks(const std::function<void(const TileLayer&)>& fn) {
+    flush();
+    if (map.getWidth() == 0 || map.getHeight() == 0) return;
+
+    auto first = ChunkedTileMap::chunkOf(GridPosition(map.getOriginX(), map.getOriginY()));
+    auto last = ChunkedTileMap::chunkOf(GridPosition(map.getOriginX() + map.getWidth() - 1,
+                                                     map.getOriginY() + map.getHeight() - 1));
+    for (int chunkY = first.y; chunkY <= last.y; ++chunkY) {
+        for (int chunkX = first.x; chunkX <= last.x; ++chunkX) {
+            if (const TileChunk* chunk = map.findChunk(chunkX, chunkY)) {
+                fn(chunk->cells);
+            } else if (auto chunk = loadOrGenerate(chunkX, chunkY)) {
+                fn(chunk->cells);
+            }
+        }
+    }
+}
+
+std::filesystem::path ChunkStreamer::chunkPath(int chunkX, int chunkY) const {
+    return settings.cacheDir / (std::to_string(chunkX) + "_" + std::to_string(chunkY) + ".chunk");
+}
+
+std::unique_ptr<TileChunk> ChunkStreamer::loadOrGenerate(int chunkX, int chunkY) const {
+    auto chunk = ChunkedTileMap::makeChunk(chunkX, chunkY);
+    std::filesystem::path path = chunkPath(chunkX, chunkY);
+
+    std::error_code error;
+    if (std::filesystem::exists(path, error)) {
+        if (readChunk(path, *chunk)) {
+            return chunk;
+        }
+        // Файл мог оборваться посередине - прочитанное не смешиваем с остальным
+        chunk = ChunkedTileMap::makeChunk(chunkX, chunkY);
+        if (!generator) {
+            std::cerr << "Cannot read chunk cache: " << path << std::endl;
+            return nullptr;
+        }
+    }
+    if (!generator) {
+        return chunk;
+    }
+    // Чанку целиком внутри карты её границы не нужны - он берётся по сиду,
+    // как в неограниченном мире; краевые обрезаются по границам
+    const LocalMapGenerator::GenerationParams& params = generator->getParams();
+    GridPosition origin = ChunkedTileMap::chunkOrigin(chunkX, chunkY);
+    if (origin.x >= 0 && origin.y >= 0 &&
+        origin.x + ChunkedTileMap::CHUNK_SIZE <= params.width &&
+        origin.y + ChunkedTileMap::CHUNK_SIZE <= params.height) {
+        return generator->generateChunk(params.seed, chunkX, chunkY);
+    }
+    generator->generateChunk(*chunk);
+    return chunk;
+}
+
+void ChunkStreamer::collectFinished(bool wait) {
+    for (auto it = pendingLoads.begin(); it != pendingLoads.end();) {
+        if (wait || engine::isReady(it->second)) {
+            std::unique_ptr<TileChunk> chunk = it->second.get();
+            if (chunk) {
+                chunk->lastUsed = frame;
+                map.insertChunk(std::move(chunk));
+            } else {
+                failedChunks.insert(it->first);
+            }
+            it = pendingLoads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = pendingWrites.begin(); it != pendingWrites.end();) {
+        if (wait || engine::isReady(it->second)) {
+            it->second.get();
+            it = pendingWrites.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ChunkStreamer::evict(int minChunkX, int minChunkY, int maxChunkX, int maxChunkY) {
+    const std::size_t budgetChunks = std::max<std::size_t>(1, settings.memoryBudget / CHUNK_BYTES);
+    if (map.getChunkCount() <= budgetChunks) return;
+
+    // Кандидаты - чанки вне нужной области, самые давно использованные первыми
+    std::vector<const TileChunk*> candidates;
+    map.forEachChunk([&](const TileChunk& chunk) {
+        bool wanted = chunk.chunkX >= minChunkX && chunk.chunkX <= maxChunkX &&
+                      chunk.chunkY >= minChunkY && chunk.chunkY <= maxChunkY;
+        if (!wanted) {
+            candidates.push_back(&chunk);
+        }
+    });
+    std::sort(candidates.begin(), candidates.end(), [](const TileChunk* a, const TileChunk* b) {
+        return a->lastUsed < b->lastUsed;
+    });
+
+    std::size_t excess = map.getChunkCount() - budgetChunks;
+    for (std::size_t i = 0; i < candidates.size() && i < excess; ++i) {
+        int chunkX = candidates[i]->chunkX, chunkY = candidates[i]->chunkY;
+        std::shared_ptr<TileChunk> chunk = map.removeChunk(chunkX, chunkY);
+        if (chunk && chunk->dirty) {
+            std::filesystem::path path = chunkPath(chunkX, chunkY);
+            pendingWrites[ChunkedTileMap::chunkKey(chunkX, chunkY)] = threadPool.submit([path, chunk]() {
+                if (!writeChunk(path, *chunk)) {
+                    std::cerr << "Cannot write chunk cache: " << path << std::endl;
+                }
+            });
+        }
+    }
+}
+
+bool ChunkStreamer::writeChunk(const std::filesystem::path& path, const TileChunk& chunk) {
+    std::error_code error;
+    std::filesystem::create_directories(path.parent_path(), error);
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    const TileLayer& cells = chunk.cells;
+    const std::size_t count = cells.getCellCount();
+    ChunkFileHeader header{CHUNK_FILE_MAGIC, CHUNK_FILE_VERSION, chunk.chunkX, chunk.chunkY,
+                           static_cast<std::uint32_t>(count)};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeArray(file, cells.typeData(), count);
+    writeArray(file, cells.walkableData(), count);
+    writeArray(file, cells.buildableData(), count);
+    writeArray(file, cells.biomeData(), count);
+    writeArray(file, cells.elevationData(), count);
+    writeArray(file, cells.fertilityData(), count);
+    writeArray(file, cells.temperatureData(), count);
+    writeArray(file, cells.humidityData(), count);
+    return static_cast<bool>(file);
+}
+
+bool ChunkStreamer::readChunk(const std::filesystem::path& path, TileChunk& chunk) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+
+    TileLayer& cells = chunk.cells;
+    const std::size_t count = cells.getCellCount();
+    ChunkFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != CHUNK_FILE_MAGIC || header.version != CHUNK_FILE_VERSION ||
+        header.chunkX != chunk.chunkX || header.chunkY != chunk.chunkY || header.cellCount != count) {
+        return false;
+    }
+
+    bool ok = readArray(file, cells.typeData(), count) &&
+              readArray(file, cells.walkableData(), count) &&
+              readArray(file, cells.buildableData(), count) &&
+              readArray(file, cells.biomeData(), count) &&
+              readArray(file, cells.elevationData(), count) &&
+              readArray(file, cells.fertilityData(), count) &&
+              readArray(file, cells.temperatureData(), count) &&
+              readArray(file, cells.humidityData(), count);
+    cells.markChanged();
+    return ok;
+}
+
+} // namespace game
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ChunkedTileMap.hpp"
+#include "LocalMapGenerator.hpp"
+#include "../../engine/core/ThreadPool.hpp"
+
+namespace game {
+    // Подгружает чанки ChunkedTileMap вокруг области обзора камеры и выгружает
+    // дальние, удерживая карту в рамках бюджета памяти.
+    //
+    // Недостающий чанк читается из кэша на диске, а если его там нет -
+    // генерируется; и то и другое выполняется в пуле потоков, а готовые чанки
+    // вставляются в карту в update() на главном потоке. При вытеснении
+    // изменённый чанк записывается в кэш (тоже в пуле), неизменённый просто
+    // удаляется - его можно сгенерировать заново.
+    class ChunkStreamer {
+    public:
+        struct Settings {
+            std::size_t memoryBudget = 64 * 1024 * 1024;  // Байт на клетки загруженных чанков
+            int preloadMargin = 1;                        // Чанков вокруг области обзора
+            std::size_t maxRequestsPerUpdate = 32;        // Новых задач за один update()
+            std::filesystem::path cacheDir = "saves/chunks";
+        };
+
+        // Примерный объём одного чанка в памяти
+        static constexpr std::size_t CHUNK_BYTES = std::size_t(ChunkedTileMap::CHUNK_SIZE) * ChunkedTileMap::CHUNK_SIZE *
+            (sizeof(TileType) + 2 * sizeof(std::uint8_t) + sizeof(BiomeType) + 4 * sizeof(float));
+
+        ChunkStreamer(ChunkedTileMap& map, engine::ThreadPool& threadPool, Settings settings);
+        ChunkStreamer(ChunkedTileMap& map, engine::ThreadPool& threadPool)
+            : ChunkStreamer(map, threadPool, Settings()) {}
+        ~ChunkStreamer();
+
+        ChunkStreamer(const ChunkStreamer&) = delete;
+        ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+        // Начало новой карты: дожидается задач в пуле, очищает дисковый кэш.
+        // generator (после beginMap) - источник отсутствующих чанков; nullptr -
+        // отсутствующие чанки остаются пустыми (например, для загруженной карты).
+        void reset(const LocalMapGenerator* generator);
+
+        // Раз в кадр, с областью обзора в клетках (углы включительно)
+        void update(const GridPosition& viewMin, const GridPosition& viewMax);
+
+        // Дожидается всех задач и вставляет готовые чанки
+        void flush();
+
+        // Чанк карты, загруженный немедленно (из кэша или генератора), если его
+        // ещё нет в памяти; nullptr вне границ карты и если файл кэша испорчен,
+        // а генератора нет. Для редких обращений вне области обзора - например,
+        // отмены правки.
+        TileChunk* acquireChunk(int chunkX, int chunkY);
+
+        // fn(const TileLayer&) для каждого чанка карты: загруженного, лежащего в
+        // кэше или (если есть генератор) сгенерированного заново; чанки с
+        // испорченным файлом кэша без генератора пропускаются. Синхронно -
+        // для сохранения карты целиком.
+        void visitAllChunks(const std::function<void(const TileLayer&)>& fn);
+
+        ChunkedTileMap& getMap() { return map; }
+        const ChunkedTileMap& getMap() const { return map; }
+        std::size_t getPendingCount() const { return pendingLoads.size() + pendingWrites.size(); }
+        std::size_t getResidentBytes() const { return map.getChunkCount() * CHUNK_BYTES; }
+        const Settings& getSettings() const { return settings; }
+
+    private:
+        ChunkedTileMap& map;
+        engine::ThreadPool& threadPool;
+        Settings settings;
+        const LocalMapGenerator* generator = nullptr;
+        std::uint64_t frame = 0;
+
+        std::unordered_map<std::uint64_t, std::future<std::unique_ptr<TileChunk>>> pendingLoads;
+        std::unordered_map<std::uint64_t, std::future<void>> pendingWrites;
+        // Чанки, которые не удалось ни прочитать, ни сгенерировать; до reset()
+        // больше не запрашиваются
+        std::unordered_set<std::uint64_t> failedChunks;
+
+        std::filesystem::path chunkPath(int chunkX, int chunkY) const;
+        std::unique_ptr<TileChunk> loadOrGenerate(int chunkX, int chunkY) const;
+        void collectFinished(bool wait);
+        void evict(int minChunkX, int minChunkY, int maxChunkX, int maxChunkY);
+
+        static bool writeChunk(const std::filesystem::path& path, const TileChunk& chunk);
+        static bool readChunk(const std::filesystem::path& path, TileChunk& chunk);
+    };
+}
@@ -0,0 +1,341 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include "../Tile.hpp"
+#include "BiomeType.hpp"
+#include "TileLayer.hpp"
+#include "TileBitmaps.hpp"
+
+namespace game {
+    // Чанк карты: квадрат CHUNK_SIZE x CHUNK_SIZE клеток со своим хранилищем
+    struct TileChunk {
+        int chunkX = 0;
+        int chunkY = 0;
+        TileLayer cells;
+        // Строятся при вставке в карту; кто пишет в cells после этого, обновляет
+        // их через bits.updateCell()
+        TileBitmaps bits;
+        // Изменён после генерации/загрузки - при выгрузке должен попасть на диск
+        bool dirty = false;
+        // Кадр последнего обращения (для вытеснения по LRU)
+        std::uint64_t lastUsed = 0;
+        // Уникален для каждой вставки в карту - кэши по нему отличают новый
+        // чанк от прежнего с теми же координатами
+        std::uint64_t serial = 0;
+    };
+
+    // Карта тайлов, разбитая на чанки 32x32. В памяти находятся только
+    // загруженные чанки (их подгружает и выгружает ChunkStreamer), поэтому
+    // размер карты ограничен диском, а не оперативной памятью.
+    // Клетка вне загруженных чанков читается как TileType::NONE.
+    //
+    // Текстуры задаются на тип тайла, модификаторы - на биом, для всей карты.
+    // Все методы вызываются из главного потока; рабочие потоки заполняют
+    // отдельные TileChunk, которые затем вставляются через insertChunk().
+    class ChunkedTileMap {
+    public:
+        static constexpr int CHUNK_SHIFT = 5;
+        static constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;
+        static constexpr int CHUNK_MASK = CHUNK_SIZE - 1;
+        static_assert(CHUNK_SIZE == TileBitmaps::SIZE, "chunk row must fit one bitmap word");
+
+        struct ChunkCoord {
+            int x;
+            int y;
+        };
+
+        // Пустая карта с границами [originX, originX + width) x [originY, originY + height)
+        void reset(int width, int height, int originX = 0, int originY = 0) {
+            this->width = width > 0 ? width : 0;
+            this->height = height > 0 ? height : 0;
+            this->originX = originX;
+            this->originY = originY;
+            chunks.clear();
+            for (auto& biomeModifiers : modifiers) {
+                biomeModifiers.clear();
+            }
+            ++version;
+        }
+
+        // Подменяет всё содержимое карты (границы, текстуры, модификаторы, чанки)
+        // содержимым other, other остаётся пустой. Чанки получают новые serial,
+        // а версия растёт, как при вставке, - кэши по карте пересчитаются
+        void replaceWith(ChunkedTileMap&& other) {
+            width = other.width;
+            height = other.height;
+            originX = other.originX;
+            originY = other.originY;
+            chunks = std::move(other.chunks);
+            textures = std::move(other.textures);
+            modifiers = std::move(other.modifiers);
+            for (auto& [key, chunk] : chunks) {
+                chunk->serial = ++nextSerial;
+            }
+            ++version;
+            other.chunks.clear();
+            other.reset(0, 0);
+        }
+
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+        int getOriginX() const { return originX; }
+        int getOriginY() const { return originY; }
+
+        // В границах карты (но чанк может быть не загружен)
+        bool contains(const GridPosition& pos) const {
+            return pos.x >= originX && pos.y >= originY &&
+                   pos.x < originX + width && pos.y < originY + height;
+        }
+
+        bool containsChunk(int chunkX, int chunkY) const {
+            ChunkCoord first = chunkOf(GridPosition(originX, originY));
+            ChunkCoord last = chunkOf(GridPosition(originX + width - 1, originY + height - 1));
+            return width > 0 && height > 0 &&
+                   chunkX >= first.x && chunkY >= first.y && chunkX <= last.x && chunkY <= last.y;
+        }
+
+        // Арифметический сдвиг - корректное округление вниз и для отрицательных координат
+        static ChunkCoord chunkOf(const GridPosition& pos) {
+            return ChunkCoord{pos.x >> CHUNK_SHIFT, pos.y >> CHUNK_SHIFT};
+        }
+
+        static GridPosition chunkOrigin(int chunkX, int chunkY) {
+            return GridPosition(chunkX * CHUNK_SIZE, chunkY * CHUNK_SIZE);
+        }
+
+        // Новый пустой чанк нужного размера (ещё не вставленный в карту)
+        static std::unique_ptr<TileChunk> makeChunk(int chunkX, int chunkY) {
+            auto chunk = std::make_unique<TileChunk>();
+            chunk->chunkX = chunkX;
+            chunk->chunkY = chunkY;
+            GridPosition origin = chunkOrigin(chunkX, chunkY);
+            chunk->cells.resize(CHUNK_SIZE, CHUNK_SIZE, origin.x, origin.y);
+            return chunk;
+        }
+
+        TileChunk* findChunk(int chunkX, int chunkY) {
+            auto it = chunks.find(chunkKey(chunkX, chunkY));
+            return it != chunks.end() ? it->second.get() : nullptr;
+        }
+
+        const TileChunk* findChunk(int chunkX, int chunkY) const {
+            auto it = chunks.find(chunkKey(chunkX, chunkY));
+            return it != chunks.end() ? it->second.get() : nullptr;
+        }
+
+        // Заменяет чанк с теми же координатами, если он уже был
+        TileChunk& insertChunk(std::unique_ptr<TileChunk> chunk) {
+            chunk->bits.rebuild(chunk->cells);
+            chunk->serial = ++nextSerial;
+            auto& slot = chunks[chunkKey(chunk->chunkX, chunk->chunkY)];
+            slot = std::move(chunk);
+            ++version;
+            return *slot;
+        }
+
+        std::unique_ptr<TileChunk> removeChunk(int chunkX, int chunkY) {
+            auto it = chunks.find(chunkKey(chunkX, chunkY));
+            if (it == chunks.end()) return nullptr;
+            std::unique_ptr<TileChunk> chunk = std::move(it->second);
+            chunks.erase(it);
+            ++version;
+            return chunk;
+        }
+
+        std::size_t getChunkCount() const { return chunks.size(); }
+
+        template<typename Func>
+        void forEachChunk(Func&& fn) {
+            for (auto& [key, chunk] : chunks) {
+                fn(*chunk);
+            }
+        }
+
+        template<typename Func>
+        void forEachChunk(Func&& fn) const {
+            for (const auto& [key, chunk] : chunks) {
+                fn(static_cast<const TileChunk&>(*chunk));
+            }
+        }
+
+        // Чанк с клеткой pos и индекс клетки в нём; nullptr, если не загружен
+        TileChunk* findCell(const GridPosition& pos, std::size_t& index) {
+            if (!contains(pos)) return nullptr;
+            ChunkCoord coord = chunkOf(pos);
+            TileChunk* chunk = findChunk(coord.x, coord.y);
+            if (chunk) {
+                index = chunk->cells.cellIndex(pos);
+            }
+            return chunk;
+        }
+
+        const TileChunk* findCell(const GridPosition& pos, std::size_t& index) const {
+            return const_cast<ChunkedTileMap*>(this)->findCell(pos, index);
+        }
+
+        TileType getType(const GridPosition& pos) const {
+            std::size_t index;
+            const TileChunk* chunk = findCell(pos, index);
+            return chunk ? chunk->cells.getType(index) : TileType::NONE;
+        }
+
+        // Клеток слоя TileBitmaps (тип, WALKABLE, BUILDABLE) в прямоугольнике
+        // [min, max] (углы включительно); учитываются только загруженные чанки
+        std::size_t countInRect(std::size_t layer, const GridPosition& min, const GridPosition& max) const {
+            std::size_t total = 0;
+            forEachChunkInRect(min, max, [&](const TileChunk& chunk, int x0, int y0, int x1, int y1) {
+                if (x0 == 0 && y0 == 0 && x1 == CHUNK_MASK && y1 == CHUNK_MASK) {
+                    total += chunk.bits.count(layer);
+                    return;
+                }
+                std::uint32_t mask = TileBitmaps::columnMask(x0, x1);
+                for (int y = y0; y <= y1; ++y) {
+                    total += TileBitmaps::bitCount(chunk.bits.row(layer, y) & mask);
+                }
+            });
+            return total;
+        }
+
+        // Все клетки прямоугольника в слое (например, можно ли здесь строить)
+        bool allInRect(std::size_t layer, const GridPosition& min, const GridPosition& max) const {
+            GridPosition low(std::max(std::min(min.x, max.x), originX), std::max(std::min(min.y, max.y), originY));
+            GridPosition high(std::min(std::max(min.x, max.x), originX + width - 1),
+                              std::min(std::max(min.y, max.y), originY + height - 1));
+            if (low.x > high.x || low.y > high.y) return false;
+            std::size_t area = static_cast<std::size_t>(high.x - low.x + 1) * (high.y - low.y + 1);
+            return countInRect(layer, min, max) == area;
+        }
+
+        // Ближайшая к from клетка слоя не дальше maxDistance (по евклиду).
+        // Чанки обходятся кольцами вокруг чанка from; обход прекращается, как
+        // только следующее кольцо заведомо дальше найденной клетки
+        bool findNearest(std::size_t layer, const GridPosition& from, GridPosition& result,
+                         int maxDistance = INT_MAX) const {
+            if (width == 0 || height == 0) return false;
+            ChunkCoord first = chunkOf(GridPosition(originX, originY));
+            ChunkCoord last = chunkOf(GridPosition(originX + width - 1, originY + height - 1));
+            ChunkCoord center = chunkOf(from);
+            int maxRing = std::max(std::max(center.x - first.x, last.x - center.x),
+                                   std::max(center.y - first.y, last.y - center.y));
+            long long limit = static_cast<long long>(maxDistance) * maxDistance;
+            long long best = LLONG_MAX;
+
+            for (int ring = 0; ring <= maxRing; ++ring) {
+                long long gap = ring > 0 ? static_cast<long long>(ring - 1) * CHUNK_SIZE + 1 : 0;
+                if (gap * gap > std::min(best, limit)) break;
+                for (int chunkY = center.y - ring; chunkY <= center.y + ring; ++chunkY) {
+                    bool edgeRow = chunkY == center.y - ring || chunkY == center.y + ring;
+                    int step = edgeRow ? 1 : 2 * ring;
+                    for (int chunkX = center.x - ring; chunkX <= center.x + ring; chunkX += std::max(step, 1)) {
+                        const TileChunk* chunk = findChunk(chunkX, chunkY);
+                        if (!chunk || chunk->bits.count(layer) == 0) continue;
+                        nearestInChunk(*chunk, layer, from, best, result);
+                    }
+                }
+            }
+            return best <= limit;
+        }
+
+        // Текстуры по типу тайла
+        const std::shared_ptr<engine::Texture>& getTexture(TileType type) const {
+            return textures[static_cast<std::size_t>(type)];
+        }
+
+        void setTexture(TileType type, const std::shared_ptr<engine::Texture>& texture) {
+            textures[static_cast<std::size_t>(type)] = texture;
+            ++version;
+        }
+
+        // Модификаторы действуют на все клетки своего биома
+        void addModifier(BiomeType biome, const std::string& key, float value) {
+            modifiers[static_cast<std::size_t>(biome)][key] = value;
+        }
+
+        void removeModifier(BiomeType biome, const std::string& key) {
+            modifiers[static_cast<std::size_t>(biome)].erase(key);
+        }
+
+        const std::unordered_map<std::string, float>& getModifiers(BiomeType biome) const {
+            return modifiers[static_cast<std::size_t>(biome)];
+        }
+
+        // Итоговое значение с учетом модификаторов биома клетки
+        float getModifiedValue(BiomeType biome, const std::string& key, float baseValue) const {
+            float totalModifier = 1.0f;
+            for (const auto& [modKey, value] : getModifiers(biome)) {
+                if (modKey.find(key) == 0) { // Если модификатор начинается с key
+                    totalModifier += value;
+                }
+            }
+            return baseValue * totalModifier;
+        }
+
+        // Растёт при вставке/удалении чанков и смене текстур; изменения клеток
+        // отражаются в версиях самих чанков (TileLayer::getVersion)
+        std::uint64_t getVersion() const { return version; }
+
+        // Ключ чанка в хеш-таблицах - здесь и у всех, кто хранит данные по чанкам
+        static std::uint64_t chunkKey(int chunkX, int chunkY) {
+            return (std::uint64_t(std::uint32_t(chunkX)) << 32) | std::uint32_t(chunkY);
+        }
+
+    private:
+        int width = 0;
+        int height = 0;
+        int originX = 0;
+        int originY = 0;
+
+        std::unordered_map<std::uint64_t, std::unique_ptr<TileChunk>> chunks;
+        std::array<std::shared_ptr<engine::Texture>, TILE_TYPE_COUNT> textures;
+        std::array<std::unordered_map<std::string, float>, BIOME_TYPE_COUNT> modifiers;
+        std::uint64_t version = 0;
+        std::uint64_t nextSerial = 0;
+
+        // fn(chunk, x0, y0, x1, y1) для загруженных чанков, пересекающих
+        // [min, max] в границах карты; x0..y1 - пересечение в координатах чанка
+        template<typename Func>
+        void forEachChunkInRect(const GridPosition& min, const GridPosition& max, Func&& fn) const {
+            GridPosition low(std::max(std::min(min.x, max.x), originX), std::max(std::min(min.y, max.y), originY));
+            GridPosition high(std::min(std::max(min.x, max.x), originX + width - 1),
+                              std::min(std::max(min.y, max.y), originY + height - 1));
+            if (low.x > high.x || low.y > high.y) return;
+            ChunkCoord firstChunk = chunkOf(low), lastChunk = chunkOf(high);
+            for (int chunkY = firstChunk.y; chunkY <= lastChunk.y; ++chunkY) {
+                for (int chunkX = firstChunk.x; chunkX <= lastChunk.x; ++chunkX) {
+                    const TileChunk* chunk = findChunk(chunkX, chunkY);
+                    if (!chunk) continue;
+                    GridPosition origin = chunkOrigin(chunkX, chunkY);
+                    fn(*chunk, std::max(low.x - origin.x, 0), std::max(low.y - origin.y, 0),
+                       std::min(high.x - origin.x, CHUNK_MASK), std::min(high.y - origin.y, CHUNK_MASK));
+                }
+            }
+        }
+
+        void nearestInChunk(const TileChunk& chunk, std::size_t layer, const GridPosition& from,
+                            long long& best, GridPosition& result) const {
+            GridPosition origin = chunkOrigin(chunk.chunkX, chunk.chunkY);
+            for (int y = 0; y < CHUNK_SIZE; ++y) {
+                std::uint32_t word = chunk.bits.row(layer, y);
+                if (!word) continue;
+                long long dy = origin.y + y - from.y;
+                if (dy * dy >= best) continue;
+                while (word) {
+                    int x = TileBitmaps::lowestBit(word);
+                    word &= word - 1;
+                    GridPosition pos(origin.x + x, origin.y + y);
+                    long long dx = pos.x - from.x;
+                    long long distance = dx * dx + dy * dy;
+                    if (distance < best && contains(pos)) {
+                        best = distance;
+                        result = pos;
+                    }
+                }
+            }
+        }
+    };
+}
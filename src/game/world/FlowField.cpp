@@ -0,0 +1,635 @@
+#include "FlowField.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <limits>
+
+namespace game {
+
+namespace {
+    constexpr int SIZE = ChunkedTileMap::CHUNK_SIZE;
+    constexpr int MASK = ChunkedTileMap::CHUNK_MASK;
+    // Сетка чанка с рамкой в одну клетку из соседних чанков
+    constexpr int LOCAL = SIZE + 2;
+    constexpr float DIAGONAL_COST = 1.41421356f;
+    constexpr float INF = std::numeric_limits<float>::infinity();
+    // Меньше стольких изменённых чанков стоимости считаются без пула
+    constexpr std::size_t PARALLEL_COSTS = 8;
+    // Ширина полосы стоимостей, чанки из которой обрабатываются в одном
+    // раунде, - примерно чанк по ровной земле. Уже - меньше повторных
+    // пересчётов, но меньше и чанков на раунд для параллельной работы
+    constexpr float ROUND_BAND = 32.0f;
+
+    // Индекс направления в FlowField::Chunk::direction -> (dx, dy)
+    constexpr int DIRECTIONS[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {-1, 1}, {1, -1}, {-1, -1}};
+
+    enum Side { RIGHT, LEFT, DOWN, UP };
+
+    // Значения на краях чанка: правый и левый столбцы, нижняя и верхняя строки
+    using Edges = std::array<std::array<float, SIZE>, 4>;
+
+    struct HeapItem {
+        float cost;
+        std::int32_t cell;
+        bool operator>(const HeapItem& other) const { return cost > other.cost; }
+    };
+
+    struct LocalGrid {
+        std::array<float, LOCAL * LOCAL> step;
+        std::array<float, LOCAL * LOCAL> elevation;
+        std::array<float, LOCAL * LOCAL> cost;
+        std::vector<HeapItem> heap;
+    };
+
+    int localIndex(int x, int y) {
+        return (y + 1) * LOCAL + x + 1;
+    }
+
+    // fn(x, y) для клеток рамки, x и y от -1 до SIZE
+    template<typename Func>
+    void forEachHalo(Func&& fn) {
+        for (int x = -1; x <= SIZE; ++x) {
+            fn(x, -1);
+            fn(x, SIZE);
+        }
+        for (int y = 0; y < SIZE; ++y) {
+            fn(-1, y);
+            fn(SIZE, y);
+        }
+    }
+
+    // Клетка (x, y) лежит на краю чанка
+    float edgeValue(const Edges& edges, int x, int y) {
+        if (x == 0) return edges[LEFT][y];
+        if (x == SIZE - 1) return edges[RIGHT][y];
+        if (y == 0) return edges[UP][x];
+        return edges[DOWN][x];
+    }
+
+    // Бит соседнего чанка (dx, dy) в маске пробуждения
+    std::uint16_t neighborBit(int dx, int dy) {
+        return static_cast<std::uint16_t>(1u << ((dy + 1) * 3 + dx + 1));
+    }
+
+    // Соседи, которых касается клетка края (x, y)
+    std::uint16_t touchedNeighbors(int x, int y) {
+        int dx = x == 0 ? -1 : (x == SIZE - 1 ? 1 : 0);
+        int dy = y == 0 ? -1 : (y == SIZE - 1 ? 1 : 0);
+        std::uint16_t mask = 0;
+        if (dx) mask |= neighborBit(dx, 0);
+        if (dy) mask |= neighborBit(0, dy);
+        if (dx && dy) mask |= neighborBit(dx, dy);
+        return mask;
+    }
+
+    // Прямой ход - в проходимую клетку, диагональ - ещё и через две проходимые
+    bool canMove(const LocalGrid& grid, int cell, int dx, int dy) {
+        if (grid.step[cell + dx + dy * LOCAL] <= 0.0f) return false;
+        return dx == 0 || dy == 0 || (grid.step[cell + dx] > 0.0f && grid.step[cell + dy * LOCAL] > 0.0f);
+    }
+
+    // Симметрична: от from к to и обратно стоит одинаково
+    float moveCost(const LocalGrid& grid, int from, int to, bool diagonal, float slopeCost) {
+        float base = 0.5f * (grid.step[from] + grid.step[to]);
+        return (diagonal ? base * DIAGONAL_COST : base) + slopeCost * std::abs(grid.elevation[from] - grid.elevation[to]);
+    }
+
+    void pushHeap(std::vector<HeapItem>& heap, float cost, std::int32_t cell) {
+        heap.push_back({cost, cell});
+        std::push_heap(heap.begin(), heap.end(), std::greater<HeapItem>());
+    }
+
+    HeapItem popHeap(std::vector<HeapItem>& heap) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<HeapItem>());
+        HeapItem item = heap.back();
+        heap.pop_back();
+        return item;
+    }
+}
+
+bool FlowField::getDirection(const GridPosition& pos, GridPosition& step) const {
+    auto coord = ChunkedTileMap::chunkOf(pos);
+    const Chunk* chunk = findChunk(coord.x, coord.y);
+    if (!chunk) return false;
+    std::uint8_t direction = chunk->direction[static_cast<std::size_t>(pos.y & MASK) * SIZE + (pos.x & MASK)];
+    if (direction == NO_DIRECTION) return false;
+    step = GridPosition(DIRECTIONS[direction][0], DIRECTIONS[direction][1]);
+    return true;
+}
+
+float FlowField::getCost(const GridPosition& pos) const {
+    auto coord = ChunkedTileMap::chunkOf(pos);
+    const Chunk* chunk = findChunk(coord.x, coord.y);
+    return chunk ? chunk->cost[static_cast<std::size_t>(pos.y & MASK) * SIZE + (pos.x & MASK)] : INF;
+}
+
+const FlowField::Chunk* FlowField::findChunk(int chunkX, int chunkY) const {
+    int column = chunkX - firstChunkX, row = chunkY - firstChunkY;
+    if (column < 0 || row < 0 || column >= columns || row >= rows) return nullptr;
+    std::int32_t slot = slots[static_cast<std::size_t>(row) * columns + column];
+    return slot >= 0 ? &chunks[slot] : nullptr;
+}
+
+std::int32_t FlowFieldCache::CostGrid::find(int chunkX, int chunkY) const {
+    int column = chunkX - firstChunkX, row = chunkY - firstChunkY;
+    if (column < 0 || row < 0 || column >= columns || row >= rows) return -1;
+    return slots[static_cast<std::size_t>(row) * columns + column];
+}
+
+// Состояние одного расчёта; задачи пула держат его сами, так что кэш может
+// перестать его ждать в любой момент
+struct FlowFieldCache::Job {
+    engine::ThreadPool* threadPool = nullptr;
+    std::shared_ptr<const CostGrid> costs;
+    std::shared_ptr<FlowField> field;
+
+    // Края каждого чанка: опубликованные после прошлого раунда (их читают
+    // соседи) и новые, которые пишет сам чанк
+    std::vector<Edges> published;
+    std::vector<Edges> pending;
+    // Соседи, чью рамку чанк улучшил в этом раунде (биты neighborBit), и
+    // наименьшее из улучшенных значений
+    std::vector<std::uint16_t> wake;
+    std::vector<float> wakeCost;
+    // Чанки, ждущие обработки, и наименьшее значение, пришедшее к ним от
+    // соседей (INF - не ждёт)
+    std::vector<std::uint32_t> waiting;
+    std::vector<float> priority;
+    std::vector<std::uint32_t> active;
+    bool integrating = true;
+    bool firstRound = true;
+
+    std::atomic<std::size_t> remaining{0};
+    std::promise<void> done;
+    std::future<void> finished;
+};
+
+FlowFieldCache::FlowFieldCache(engine::ThreadPool& threadPool, Settings settings)
+    : threadPool(threadPool), settings(settings) {
+}
+
+FlowFieldCache::~FlowFieldCache() {
+    collectFinished(true);
+}
+
+void FlowFieldCache::update(const ChunkedTileMap& map) {
+    ++frame;
+    bool changed = false;
+    if (syncedMap != &map) {
+        costs.clear();
+        syncedMap = &map;
+        syncedMapVersion = map.getVersion();
+        changed = true;
+    } else if (syncedMapVersion != map.getVersion()) {
+        for (auto it = costs.begin(); it != costs.end();) {
+            const TileChunk* chunk = map.findChunk(it->second.costs->chunkX, it->second.costs->chunkY);
+            if (!chunk || chunk->serial != it->second.serial) {
+                it = costs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        syncedMapVersion = map.getVersion();
+        changed = true;
+    }
+
+    std::vector<const TileChunk*> stale;
+    map.forEachChunk([&](const TileChunk& chunk) {
+        auto it = costs.find(ChunkedTileMap::chunkKey(chunk.chunkX, chunk.chunkY));
+        if (it == costs.end() || it->second.serial != chunk.serial || it->second.version != chunk.cells.getVersion()) {
+            stale.push_back(&chunk);
+        }
+    });
+
+    if (!stale.empty()) {
+        std::vector<std::unique_ptr<ChunkCosts>> fresh(stale.size());
+        if (stale.size() < PARALLEL_COSTS) {
+            for (std::size_t i = 0; i < stale.size(); ++i) {
+                fresh[i] = computeCosts(*stale[i]);
+            }
+        } else {
+            // Карта не меняется, пока главный поток ждёт
+            std::size_t batchCount = std::min(threadPool.getThreadCount(), stale.size());
+            std::vector<std::future<void>> batches;
+            for (std::size_t batch = 0; batch < batchCount; ++batch) {
+                std::size_t begin = stale.size() * batch / batchCount, end = stale.size() * (batch + 1) / batchCount;
+                batches.push_back(threadPool.submit([this, &stale, &fresh, begin, end]() {
+                    for (std::size_t i = begin; i < end; ++i) {
+                        fresh[i] = computeCosts(*stale[i]);
+                    }
+                }));
+            }
+            for (auto& batch : batches) {
+                batch.get();
+            }
+        }
+
+        for (std::size_t i = 0; i < stale.size(); ++i) {
+            CostEntry& entry = costs[ChunkedTileMap::chunkKey(stale[i]->chunkX, stale[i]->chunkY)];
+            entry.serial = stale[i]->serial;
+            entry.version = stale[i]->cells.getVersion();
+            // Правка, не затронувшая стоимостей (плодородие, биом), поля не сбрасывает
+            if (!entry.costs || entry.costs->step != fresh[i]->step || entry.costs->elevation != fresh[i]->elevation) {
+                entry.costs = std::move(fresh[i]);
+                changed = true;
+            }
+        }
+    }
+
+    if (changed) {
+        rebuildCostGrid(map);
+    }
+    collectFinished(false);
+    evict();
+}
+
+std::shared_ptr<const FlowField> FlowFieldCache::request(const std::vector<GridPosition>& goals) {
+    FieldKey fieldKey;
+    fieldKey.reserve(goals.size());
+    for (const GridPosition& goal : goals) {
+        fieldKey.emplace_back(goal.x, goal.y);
+    }
+    std::sort(fieldKey.begin(), fieldKey.end());
+    fieldKey.erase(std::unique(fieldKey.begin(), fieldKey.end()), fieldKey.end());
+
+    Entry& entry = fields[fieldKey];
+    entry.lastUsed = frame;
+    if (!entry.job && costGrid && (!entry.field || entry.field->getCostVersion() != costVersion)) {
+        entry.job = startJob(fieldKey);
+    }
+    return entry.field;
+}
+
+void FlowFieldCache::flush() {
+    collectFinished(true);
+}
+
+std::size_t FlowFieldCache::getRunningCount() const {
+    std::size_t count = 0;
+    for (const auto& [fieldKey, entry] : fields) {
+        count += entry.job ? 1 : 0;
+    }
+    return count;
+}
+
+std::unique_ptr<FlowFieldCache::ChunkCosts> FlowFieldCache::computeCosts(const TileChunk& chunk) const {
+    auto result = std::make_unique<ChunkCosts>();
+    result->chunkX = chunk.chunkX;
+    result->chunkY = chunk.chunkY;
+    result->step.fill(0.0f);
+    result->elevation.fill(0.0f);
+    if (chunk.cells.getCellCount() != result->step.size()) return result;
+
+    const TileType* types = chunk.cells.typeData();
+    const std::uint8_t* walkable = chunk.cells.walkableData();
+    const float* elevation = chunk.cells.elevationData();
+    for (std::size_t i = 0; i < result->step.size(); ++i) {
+        float multiplier = settings.typeCosts[static_cast<std::size_t>(types[i])];
+        result->step[i] = walkable[i] && multiplier > 0.0f ? multiplier : 0.0f;
+        result->elevation[i] = elevation[i];
+    }
+    return result;
+}
+
+void FlowFieldCache::rebuildCostGrid(const ChunkedTileMap& map) {
+    auto grid = std::make_shared<CostGrid>();
+    grid->version = ++costVersion;
+    grid->slopeCost = settings.slopeCost;
+    if (map.getWidth() > 0 && map.getHeight() > 0) {
+        auto first = ChunkedTileMap::chunkOf(GridPosition(map.getOriginX(), map.getOriginY()));
+        auto last = ChunkedTileMap::chunkOf(GridPosition(map.getOriginX() + map.getWidth() - 1,
+                                                         map.getOriginY() + map.getHeight() - 1));
+        grid->firstChunkX = first.x;
+        grid->firstChunkY = first.y;
+        grid->columns = last.x - first.x + 1;
+        grid->rows = last.y - first.y + 1;
+        grid->slots.assign(static_cast<std::size_t>(grid->columns) * grid->rows, -1);
+
+        // Порядок чанков - по строкам, чтобы он не зависел от хэш-таблицы
+        for (const auto& [chunkKey, entry] : costs) {
+            int column = entry.costs->chunkX - grid->firstChunkX, row = entry.costs->chunkY - grid->firstChunkY;
+            if (column < 0 || row < 0 || column >= grid->columns || row >= grid->rows) continue;
+            grid->slots[static_cast<std::size_t>(row) * grid->columns + column] = 0;
+        }
+        for (std::size_t slot = 0; slot < grid->slots.size(); ++slot) {
+            if (grid->slots[slot] < 0) continue;
+            int chunkX = grid->firstChunkX + static_cast<int>(slot % grid->columns);
+            int chunkY = grid->firstChunkY + static_cast<int>(slot / grid->columns);
+            grid->slots[slot] = static_cast<std::int32_t>(grid->chunks.size());
+            grid->chunks.push_back(costs.at(ChunkedTileMap::chunkKey(chunkX, chunkY)).costs);
+        }
+    }
+    costGrid = std::move(grid);
+}
+
+void FlowFieldCache::collectFinished(bool wait) {
+    for (auto& [fieldKey, entry] : fields) {
+        if (!entry.job || (!wait && !engine::isReady(entry.job->finished))) continue;
+        entry.job->finished.get();
+        entry.field = entry.job->field;
+        entry.job.reset();
+    }
+}
+
+void FlowFieldCache::evict() {
+    while (fields.size() > settings.maxFields) {
+        auto oldest = fields.end();
+        for (auto it = fields.begin(); it != fields.end(); ++it) {
+            if (!it->second.job && (oldest == fields.end() || it->second.lastUsed < oldest->second.lastUsed)) {
+                oldest = it;
+            }
+        }
+        if (oldest == fields.end() || oldest->second.lastUsed == frame) break;
+        fields.erase(oldest);
+    }
+}
+
+std::shared_ptr<FlowFieldCache::Job> FlowFieldCache::startJob(const FieldKey& goals) {
+    const CostGrid& grid = *costGrid;
+    auto job = std::make_shared<Job>();
+    job->threadPool = &threadPool;
+    job->costs = costGrid;
+
+    auto field = std::make_shared<FlowField>();
+    for (const auto& [x, y] : goals) {
+        field->goals.emplace_back(x, y);
+    }
+    field->costVersion = grid.version;
+    field->firstChunkX = grid.firstChunkX;
+    field->firstChunkY = grid.firstChunkY;
+    field->columns = grid.columns;
+    field->rows = grid.rows;
+    field->slots = grid.slots;
+    field->chunks.resize(grid.chunks.size());
+    for (FlowField::Chunk& chunk : field->chunks) {
+        chunk.cost.fill(INF);
+        chunk.direction.fill(FlowField::NO_DIRECTION);
+    }
+    job->field = field;
+
+    Edges unreached;
+    for (auto& side : unreached) {
+        side.fill(INF);
+    }
+    job->published.assign(grid.chunks.size(), unreached);
+    job->pending.assign(grid.chunks.size(), unreached);
+    job->wake.assign(grid.chunks.size(), 0);
+    job->wakeCost.assign(grid.chunks.size(), INF);
+    job->priority.assign(grid.chunks.size(), INF);
+
+    // Первый раунд - чанки с целями
+    for (const GridPosition& goal : field->goals) {
+        auto coord = ChunkedTileMap::chunkOf(goal);
+        std::int32_t chunk = grid.find(coord.x, coord.y);
+        if (chunk >= 0 && std::find(job->active.begin(), job->active.end(), chunk) == job->active.end()) {
+            job->active.push_back(static_cast<std::uint32_t>(chunk));
+        }
+    }
+
+    job->finished = job->done.get_future();
+    runRound(job);
+    return job;
+}
+
+void FlowFieldCache::runRound(const std::shared_ptr<Job>& job) {
+    if (job->active.empty()) {
+        if (!job->integrating || job->field->chunks.empty()) {
+            job->done.set_value();
+            return;
+        }
+        // Интеграция сошлась - направления для всех чанков
+        job->integrating = false;
+        job->active.resize(job->field->chunks.size());
+        for (std::size_t i = 0; i < job->active.size(); ++i) {
+            job->active[i] = static_cast<std::uint32_t>(i);
+        }
+    }
+
+    // Задач - не больше потоков: чанк обрабатывается за микросекунды
+    const std::size_t batchCount = std::min(job->threadPool->getThreadCount(), job->active.size());
+    job->remaining = batchCount;
+    for (std::size_t batch = 0; batch < batchCount; ++batch) {
+        std::size_t begin = job->active.size() * batch / batchCount;
+        std::size_t end = job->active.size() * (batch + 1) / batchCount;
+        job->threadPool->submit([job, begin, end]() {
+            for (std::size_t i = begin; i < end; ++i) {
+                if (job->integrating) {
+                    integrateChunk(*job, job->active[i]);
+                } else {
+                    computeDirections(*job, job->active[i]);
+                }
+            }
+            // Последняя задача раунда запускает следующий - без ожидания в пуле
+            if (job->remaining.fetch_sub(1) == 1) {
+                finishRound(job);
+            }
+        });
+    }
+}
+
+void FlowFieldCache::finishRound(const std::shared_ptr<Job>& job) {
+    if (!job->integrating) {
+        job->done.set_value();
+        return;
+    }
+
+    const CostGrid& grid = *job->costs;
+    for (std::uint32_t chunk : job->active) {
+        job->published[chunk] = job->pending[chunk];
+        std::uint16_t wake = job->wake[chunk];
+        if (!wake) continue;
+        const ChunkCosts& costs = *grid.chunks[chunk];
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (!(wake & neighborBit(dx, dy))) continue;
+                std::int32_t neighbor = grid.find(costs.chunkX + dx, costs.chunkY + dy);
+                if (neighbor < 0) continue;
+                if (job->priority[neighbor] == INF) {
+                    job->waiting.push_back(static_cast<std::uint32_t>(neighbor));
+                }
+                job->priority[neighbor] = std::min(job->priority[neighbor], job->wakeCost[chunk]);
+            }
+        }
+    }
+
+    // Следующий раунд - только ждущие чанки с самыми дешёвыми входами, как
+    // в delta-stepping: дальние подождут, пока до них дойдёт окончательный
+    // фронт, а не будут пересчитываться на каждом его шаге
+    float lowest = INF;
+    for (std::uint32_t chunk : job->waiting) {
+        lowest = std::min(lowest, job->priority[chunk]);
+    }
+    job->active.clear();
+    std::size_t kept = 0;
+    for (std::uint32_t chunk : job->waiting) {
+        if (job->priority[chunk] <= lowest + ROUND_BAND) {
+            job->priority[chunk] = INF;
+            job->active.push_back(chunk);
+        } else {
+            job->waiting[kept++] = chunk;
+        }
+    }
+    job->waiting.resize(kept);
+    job->firstRound = false;
+    runRound(job);
+}
+
+namespace {
+    // Стоимости шага и высоты чанка с рамкой из соседей; незагруженное непроходимо.
+    // around[dy + 1][dx + 1] - индексы соседних чанков или -1
+    template<typename CostGrid>
+    void loadLocal(const CostGrid& grid, std::uint32_t chunk, LocalGrid& local, std::int32_t (&around)[3][3]) {
+        const auto& center = *grid.chunks[chunk];
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                around[dy + 1][dx + 1] = grid.find(center.chunkX + dx, center.chunkY + dy);
+            }
+        }
+
+        local.step.fill(0.0f);
+        local.elevation.fill(0.0f);
+        for (int y = 0; y < SIZE; ++y) {
+            std::copy_n(&center.step[static_cast<std::size_t>(y) * SIZE], SIZE, &local.step[localIndex(0, y)]);
+            std::copy_n(&center.elevation[static_cast<std::size_t>(y) * SIZE], SIZE, &local.elevation[localIndex(0, y)]);
+        }
+        forEachHalo([&](int x, int y) {
+            std::int32_t neighbor = around[(y >= 0) + (y >= SIZE)][(x >= 0) + (x >= SIZE)];
+            if (neighbor < 0) return;
+            const auto& costs = *grid.chunks[neighbor];
+            std::size_t cell = static_cast<std::size_t>(y & MASK) * SIZE + (x & MASK);
+            local.step[localIndex(x, y)] = costs.step[cell];
+            local.elevation[localIndex(x, y)] = costs.elevation[cell];
+        });
+    }
+}
+
+void FlowFieldCache::integrateChunk(Job& job, std::uint32_t chunk) {
+    thread_local LocalGrid local;
+    const CostGrid& grid = *job.costs;
+    std::int32_t around[3][3];
+    loadLocal(grid, chunk, local, around);
+
+    FlowField::Chunk& out = job.field->chunks[chunk];
+    local.cost.fill(INF);
+    for (int y = 0; y < SIZE; ++y) {
+        std::copy_n(&out.cost[static_cast<std::size_t>(y) * SIZE], SIZE, &local.cost[localIndex(0, y)]);
+    }
+
+    // Источники - клетки рамки со значениями соседей на конец прошлого раунда
+    local.heap.clear();
+    forEachHalo([&](int x, int y) {
+        std::int32_t neighbor = around[(y >= 0) + (y >= SIZE)][(x >= 0) + (x >= SIZE)];
+        int index = localIndex(x, y);
+        if (neighbor < 0 || local.step[index] <= 0.0f) return;
+        float cost = edgeValue(job.published[neighbor], x & MASK, y & MASK);
+        if (cost < INF) {
+            local.cost[index] = cost;
+            pushHeap(local.heap, cost, index);
+        }
+    });
+    if (job.firstRound) {
+        const ChunkCosts& center = *grid.chunks[chunk];
+        GridPosition origin = ChunkedTileMap::chunkOrigin(center.chunkX, center.chunkY);
+        for (const GridPosition& goal : job.field->goals) {
+            int x = goal.x - origin.x, y = goal.y - origin.y;
+            if (x < 0 || y < 0 || x >= SIZE || y >= SIZE) continue;
+            int index = localIndex(x, y);
+            if (local.step[index] > 0.0f && local.cost[index] > 0.0f) {
+                local.cost[index] = 0.0f;
+                pushHeap(local.heap, 0.0f, index);
+            }
+        }
+    }
+
+    // Дейкстра внутри чанка; в рамку не пишем - её уточнит сам сосед
+    while (!local.heap.empty()) {
+        HeapItem item = popHeap(local.heap);
+        if (item.cost > local.cost[item.cell]) continue;
+        int x = item.cell % LOCAL - 1, y = item.cell / LOCAL - 1;
+        for (const auto& direction : DIRECTIONS) {
+            int dx = direction[0], dy = direction[1];
+            if (x + dx < 0 || y + dy < 0 || x + dx >= SIZE || y + dy >= SIZE) continue;
+            if (!canMove(local, item.cell, dx, dy)) continue;
+            int next = item.cell + dx + dy * LOCAL;
+            float cost = item.cost + moveCost(local, item.cell, next, dx != 0 && dy != 0, grid.slopeCost);
+            if (cost < local.cost[next]) {
+                local.cost[next] = cost;
+                pushHeap(local.heap, cost, next);
+            }
+        }
+    }
+
+    for (int y = 0; y < SIZE; ++y) {
+        std::copy_n(&local.cost[localIndex(0, y)], SIZE, &out.cost[static_cast<std::size_t>(y) * SIZE]);
+    }
+    Edges& edges = job.pending[chunk];
+    const Edges& before = job.published[chunk];
+    std::uint16_t wake = 0;
+    float wakeCost = INF;
+    auto compare = [&](int side, int i, int x, int y) {
+        if (edges[side][i] < before[side][i]) {
+            wake |= touchedNeighbors(x, y);
+            wakeCost = std::min(wakeCost, edges[side][i]);
+        }
+    };
+    for (int i = 0; i < SIZE; ++i) {
+        edges[RIGHT][i] = out.cost[static_cast<std::size_t>(i) * SIZE + SIZE - 1];
+        edges[LEFT][i] = out.cost[static_cast<std::size_t>(i) * SIZE];
+        edges[DOWN][i] = out.cost[static_cast<std::size_t>(SIZE - 1) * SIZE + i];
+        edges[UP][i] = out.cost[i];
+        compare(RIGHT, i, SIZE - 1, i);
+        compare(LEFT, i, 0, i);
+        compare(DOWN, i, i, SIZE - 1);
+        compare(UP, i, i, 0);
+    }
+    job.wake[chunk] = wake;
+    job.wakeCost[chunk] = wakeCost;
+}
+
+void FlowFieldCache::computeDirections(Job& job, std::uint32_t chunk) {
+    thread_local LocalGrid local;
+    const CostGrid& grid = *job.costs;
+    std::int32_t around[3][3];
+    loadLocal(grid, chunk, local, around);
+
+    // Интеграция закончена - стоимости соседей читаются напрямую
+    const std::vector<FlowField::Chunk>& chunks = job.field->chunks;
+    FlowField::Chunk& out = job.field->chunks[chunk];
+    local.cost.fill(INF);
+    for (int y = 0; y < SIZE; ++y) {
+        std::copy_n(&out.cost[static_cast<std::size_t>(y) * SIZE], SIZE, &local.cost[localIndex(0, y)]);
+    }
+    forEachHalo([&](int x, int y) {
+        std::int32_t neighbor = around[(y >= 0) + (y >= SIZE)][(x >= 0) + (x >= SIZE)];
+        if (neighbor >= 0) {
+            local.cost[localIndex(x, y)] = chunks[neighbor].cost[static_cast<std::size_t>(y & MASK) * SIZE + (x & MASK)];
+        }
+    });
+
+    // Шаг в соседа, через которого проходит кратчайший путь; при равенстве -
+    // первый по таблице, так что поле детерминировано
+    for (int y = 0; y < SIZE; ++y) {
+        for (int x = 0; x < SIZE; ++x) {
+            int cell = localIndex(x, y);
+            std::uint8_t best = FlowField::NO_DIRECTION;
+            float bestCost = INF;
+            if (local.step[cell] > 0.0f && local.cost[cell] < INF) {
+                for (std::uint8_t d = 0; d < 8; ++d) {
+                    int dx = DIRECTIONS[d][0], dy = DIRECTIONS[d][1];
+                    int next = cell + dx + dy * LOCAL;
+                    if (!(local.cost[next] < local.cost[cell]) || !canMove(local, cell, dx, dy)) continue;
+                    float cost = local.cost[next] + moveCost(local, cell, next, dx != 0 && dy != 0, grid.slopeCost);
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        best = d;
+                    }
+                }
+            }
+            out.direction[static_cast<std::size_t>(y) * SIZE + x] = best;
+        }
+    }
+}
+
+} // namespace game
@@ -0,0 +1,180 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ChunkedTileMap.hpp"
+#include "../../engine/core/ThreadPool.hpp"
+
+namespace game {
+    // Поле потока к ближайшей из нескольких целей по всем загруженным чанкам:
+    // для каждой клетки - накопленная стоимость пути до цели и направление
+    // первого шага. Толпа, идущая к одному складу или выходу, читает одно
+    // поле вместо поиска пути на каждого агента.
+    //
+    // Ходы те же, что у PathFinder: 8 направлений без срезания углов.
+    // Неизменяемо после расчёта; читать можно из любого потока.
+    class FlowField {
+    public:
+        // Шаг (dx, dy из -1..1) из pos к цели; false - pos сама цель,
+        // непроходима, цель недостижима или чанк не входил в поле
+        bool getDirection(const GridPosition& pos, GridPosition& step) const;
+
+        // Стоимость пути от pos до ближайшей цели; бесконечность - недостижима
+        float getCost(const GridPosition& pos) const;
+
+        const std::vector<GridPosition>& getGoals() const { return goals; }
+        std::size_t getChunkCount() const { return chunks.size(); }
+        // Версия стоимостей FlowFieldCache, по которой посчитано поле
+        std::uint64_t getCostVersion() const { return costVersion; }
+
+    private:
+        friend class FlowFieldCache;
+
+        static constexpr int SIZE = ChunkedTileMap::CHUNK_SIZE;
+        static constexpr std::uint8_t NO_DIRECTION = 8;
+
+        struct Chunk {
+            std::array<float, SIZE * SIZE> cost;
+            // Индекс в таблице направлений или NO_DIRECTION
+            std::array<std::uint8_t, SIZE * SIZE> direction;
+        };
+
+        std::vector<GridPosition> goals;
+        std::uint64_t costVersion = 0;
+        // Прямоугольник чанков карты; slots - индекс в chunks или -1
+        int firstChunkX = 0;
+        int firstChunkY = 0;
+        int columns = 0;
+        int rows = 0;
+        std::vector<std::int32_t> slots;
+        std::vector<Chunk> chunks;
+
+        const Chunk* findChunk(int chunkX, int chunkY) const;
+    };
+
+    // Стоимости шага по клеткам загруженных чанков и кэш полей потока по
+    // наборам целей.
+    //
+    // Стоимость шага между соседними клетками - среднее множителей типа двух
+    // клеток (диагональ дороже в sqrt(2) раз) плюс надбавка за разницу высот.
+    // update() пересчитывает множители только изменившихся чанков, причём в
+    // пуле потоков; чанк, у которого после правки множители и высоты не
+    // изменились, поля не сбрасывает.
+    //
+    // Поле считается в пуле, без ожидания на главном потоке. Интеграция идёт
+    // раундами: в каждом раунде параллельно обрабатываются чанки, до которых
+    // дошёл фронт, - Дейкстра внутри чанка от его рамки, где значения
+    // соседей взяты из прошлого раунда. Чанки берутся полосами по стоимости
+    // входа, так что почти каждый считается один раз. Раунды повторяются,
+    // пока граница хоть одного чанка улучшается; итог совпадает с Дейкстрой
+    // по всей карте и не зависит от числа потоков. Затем направления
+    // считаются по чанкам тоже параллельно.
+    //
+    // После правки карты поле устаревает: request() продолжает отдавать
+    // прежнее, пока новое не будет готово.
+    class FlowFieldCache {
+    public:
+        struct Settings {
+            // Множитель стоимости шага по типу тайла; 0 - не пройти.
+            // Порядок - как в TileType
+            std::array<float, TILE_TYPE_COUNT> typeCosts{0.0f, 1.0f, 4.0f, 1.2f, 1.0f, 3.0f, 1.5f, 2.0f, 2.0f};
+            // Надбавка к шагу за единицу разницы высот соседних клеток
+            float slopeCost = 8.0f;
+            // Сколько полей держать; давно не запрошенные вытесняются
+            std::size_t maxFields = 8;
+        };
+
+        FlowFieldCache(engine::ThreadPool& threadPool, Settings settings);
+        explicit FlowFieldCache(engine::ThreadPool& threadPool)
+            : FlowFieldCache(threadPool, Settings()) {}
+        ~FlowFieldCache();
+
+        FlowFieldCache(const FlowFieldCache&) = delete;
+        FlowFieldCache& operator=(const FlowFieldCache&) = delete;
+
+        // Раз в кадр после изменений карты: обновляет стоимости и принимает
+        // готовые поля
+        void update(const ChunkedTileMap& map);
+
+        // Поле к ближайшей из goals (порядок и повторы не важны). Если поля
+        // ещё нет или оно устарело, запускается расчёт; до его окончания
+        // возвращается прежнее поле или nullptr
+        std::shared_ptr<const FlowField> request(const std::vector<GridPosition>& goals);
+
+        // Дожидается всех расчётов и принимает их результаты
+        void flush();
+
+        std::size_t getFieldCount() const { return fields.size(); }
+        std::size_t getRunningCount() const;
+        // Растёт при каждом изменении стоимостей
+        std::uint64_t getCostVersion() const { return costVersion; }
+
+    private:
+        static constexpr int SIZE = ChunkedTileMap::CHUNK_SIZE;
+
+        struct ChunkCosts {
+            int chunkX = 0;
+            int chunkY = 0;
+            // Множитель шага на клетку, 0 - непроходимо
+            std::array<float, SIZE * SIZE> step;
+            std::array<float, SIZE * SIZE> elevation;
+        };
+
+        struct CostEntry {
+            std::uint64_t serial = 0;
+            std::uint64_t version = 0;
+            std::shared_ptr<const ChunkCosts> costs;
+        };
+
+        // Неизменяемый снимок стоимостей для расчётов в пуле
+        struct CostGrid {
+            int firstChunkX = 0;
+            int firstChunkY = 0;
+            int columns = 0;
+            int rows = 0;
+            std::vector<std::int32_t> slots;
+            std::vector<std::shared_ptr<const ChunkCosts>> chunks;
+            std::uint64_t version = 0;
+            float slopeCost = 0.0f;
+
+            // Индекс в chunks или -1
+            std::int32_t find(int chunkX, int chunkY) const;
+        };
+
+        struct Job;
+
+        struct Entry {
+            std::shared_ptr<const FlowField> field;
+            std::shared_ptr<Job> job;
+            std::uint64_t lastUsed = 0;
+        };
+
+        using FieldKey = std::vector<std::pair<int, int>>;
+
+        engine::ThreadPool& threadPool;
+        Settings settings;
+        const ChunkedTileMap* syncedMap = nullptr;
+        std::uint64_t syncedMapVersion = 0;
+        std::uint64_t frame = 0;
+
+        std::unordered_map<std::uint64_t, CostEntry> costs;
+        std::shared_ptr<const CostGrid> costGrid;
+        std::uint64_t costVersion = 0;
+        std::map<FieldKey, Entry> fields;
+
+        std::unique_ptr<ChunkCosts> computeCosts(const TileChunk& chunk) const;
+        void rebuildCostGrid(const ChunkedTileMap& map);
+        void collectFinished(bool wait);
+        void evict();
+
+        std::shared_ptr<Job> startJob(const FieldKey& goals);
+        static void runRound(const std::shared_ptr<Job>& job);
+        static void finishRound(const std::shared_ptr<Job>& job);
+        static void integrateChunk(Job& job, std::uint32_t chunk);
+        static void computeDirections(Job& job, std::uint32_t chunk);
+    };
+}
@@ -1,90 +1,157 @@
 #include "LocalMapGenerator.hpp"
 #include "TileRegistry.hpp"
-#include "ExtendedTileComponent.hpp"
 #include "BiomeType.hpp"
 #include <random>
 #include <algorithm>
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <vector>
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
 namespace game {
 
-void LocalMapGenerator::generateMap(engine::World& world, 
-                                 engine::TileSystem& tileSystem,
-                                 const WorldMap::WorldTile& globalTile,
-                                 const GenerationParams& params) {
+void LocalMapGenerator::beginMap(ChunkedTileMap& map,
+                              const WorldMap::WorldTile& globalTile,
+                              const GenerationParams& params) {
    std::random_device rd;
-   uint32_t seed = params.seed == 0 ? rd() : params.seed;
-   
-   // Pre-generate noise maps
-   std::vector<float> elevationMap(params.width * params.height);
-   std::vector<float> moistureMap(params.width * params.height);
-   std::vector<TileType> tileTypeMap(params.width * params.height);
-   std::vector<TileData> tileDataMap(params.width * params.height);
-   
-   noise.SetSeed(seed);
-   noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-   noise.SetFrequency(0.02f * params.detailLevel);
-
-   // Parallel generation of noise maps
-   //#pragma omp parallel for
-   for (int y = 0; y < params.height; ++y) {
-       for (int x = 0; x < params.width; ++x) {
-           int index = y * params.width + x;
-           elevationMap[index] = generateElevation(x, y, params);
-           moistureMap[index] = generateMoisture(x, y, params);
-           tileTypeMap[index] = determineTileType(elevationMap[index], moistureMap[index], globalTile);
-           tileDataMap[index] = tileRegistry.createTileData(tileTypeMap[index]);
+   activeParams = params;
+   activeParams.seed = params.seed == 0 ? rd() : params.seed;
+   activeTile = globalTile;
+
+   mapNoise = makeNoise(activeParams.seed, params.detailLevel);
+
+   map.reset(params.width, params.height);
+
+   // Tile data (texture lookup, config) is resolved once per type, here on the
+   // calling thread, so generateChunk() never touches the registry or GL
+   for (std::size_t type = 1; type < TILE_TYPE_COUNT; ++type) {
+       TileType tileType = static_cast<TileType>(type);
+       TypeInfo& info = typeInfos[type];
+       info.data = tileRegistry.createTileData(tileType);
+       try {
+           info.hasProperties = tileRegistry.getTileConfig(tileType).id != 0;
+       } catch (const std::runtime_error&) {
+           info.hasProperties = false;
        }
+       map.setTexture(info.data.type, info.data.texture);
    }
+   applyBiomeModifiers(map, globalTile.biome);
+   mapBegun = true;
+}
 
-   // Batch entity creation
-   std::vector<engine::Entity*> createdEntities;
-   createdEntities.reserve(params.width * params.height);
-
-   for (int y = 0; y < params.height; ++y) {
-       for (int x = 0; x < params.width; ++x) {
-           int index = y * params.width + x;
-           auto* entity = tileSystem.createTile(world, tileDataMap[index], {x, y});
-           createdEntities.push_back(entity);
-           
-           if (auto* extTile = entity->getComponent<ExtendedTileComponent>()) {
-               if (tileRegistry.getTileConfig(tileTypeMap[index]).id != 0) {
-                   setTileProperties(extTile, elevationMap[index], moistureMap[index], globalTile);
-                   applyBiomeModifiers(extTile, globalTile.biome);
-               }
-           }
-       }
+void LocalMapGenerator::generateChunk(TileChunk& chunk) const {
+   generateCells(chunk, mapNoise, true);
+}
+
+std::unique_ptr<TileChunk> LocalMapGenerator::generateChunk(std::uint32_t seed, int chunkX, int chunkY) const {
+   if (!mapBegun) {
+       throw std::runtime_error("LocalMapGenerator::generateChunk() called before beginMap()");
    }
+   auto chunk = ChunkedTileMap::makeChunk(chunkX, chunkY);
+   generateCells(*chunk, makeNoise(seed, activeParams.detailLevel), false);
+   return chunk;
 }
 
-float LocalMapGenerator::generateElevation(int x, int y, const GenerationParams& params) {
-   float e = 0.0f;
-   float amp = 1.0f;
-   float freq = 1.0f;
-   
-   for (int i = 0; i < 4; i++) {
-       e += noise.GetNoise(x * freq, y * freq) * amp;
-       amp *= 0.5f;
-       freq *= 2.0f;
+LocalMapGenerator::Noise LocalMapGenerator::makeNoise(std::uint32_t seed, float detailLevel) {
+   return Noise{engine::BatchNoise(static_cast<int>(seed), 0.02f * detailLevel, 4),
+                engine::BatchNoise(1234, 0.015f * detailLevel)}; // Временный константный сид влажности
+}
+
+void LocalMapGenerator::generateCells(TileChunk& chunk, const Noise& noise, bool clipToMap) const {
+   ChunkFields fields;
+   generateNoiseFields(chunk.cells, noise, clipToMap, fields);
+   classifyTiles(fields);
+   assignTiles(chunk.cells, fields);
+}
+
+void LocalMapGenerator::generateMap(ChunkedTileMap& map,
+                                 const WorldMap::WorldTile& globalTile,
+                                 const GenerationParams& params) {
+   beginMap(map, globalTile, params);
+
+   const int chunksX = (params.width + ChunkedTileMap::CHUNK_SIZE - 1) / ChunkedTileMap::CHUNK_SIZE;
+   const int chunksY = (params.height + ChunkedTileMap::CHUNK_SIZE - 1) / ChunkedTileMap::CHUNK_SIZE;
+   const int chunkCount = chunksX * chunksY;
+   std::vector<std::unique_ptr<TileChunk>> chunks(static_cast<std::size_t>(chunkCount));
+
+   // Чанки независимы, а генерация только читает состояние после beginMap();
+   // в карту они вставляются уже на этом потоке и всегда в одном порядке
+   #pragma omp parallel for schedule(dynamic)
+   for (int i = 0; i < chunkCount; ++i) {
+       auto chunk = ChunkedTileMap::makeChunk(i % chunksX, i / chunksX);
+       generateChunk(*chunk);
+       chunks[i] = std::move(chunk);
+   }
+   for (auto& chunk : chunks) {
+       map.insertChunk(std::move(chunk));
+   }
+}
+
+void LocalMapGenerator::generateNoiseFields(const TileLayer& cells, const Noise& noise, bool clipToMap,
+                                            ChunkFields& fields) const {
+   const int size = ChunkedTileMap::CHUNK_SIZE;
+   const int originX = cells.getOriginX(), originY = cells.getOriginY();
+   if (clipToMap) {
+       fields.x0 = std::clamp(-originX, 0, size);
+       fields.y0 = std::clamp(-originY, 0, size);
+       fields.x1 = std::clamp(activeParams.width - originX, fields.x0, size);
+       fields.y1 = std::clamp(activeParams.height - originY, fields.y0, size);
+   } else {
+       fields.x0 = 0;
+       fields.y0 = 0;
+       fields.x1 = size;
+       fields.y1 = size;
+   }
+
+   if (fields.x0 == fields.x1 || fields.y0 == fields.y1) return;
+
+   // Шум строками чанка сразу (SIMD), затем поправки по клеткам
+   const int width = fields.x1 - fields.x0;
+   const std::size_t first = static_cast<std::size_t>(fields.y0) * size + fields.x0;
+   noise.elevation.fillRect(originX + fields.x0, originY + fields.y0, width, fields.y1 - fields.y0,
+                            fields.elevation.data() + first, size);
+   noise.moisture.fillRect(originX + fields.x0, originY + fields.y0, width, fields.y1 - fields.y0,
+                           fields.moisture.data() + first, size);
+
+   for (int y = fields.y0; y < fields.y1; ++y) {
+       for (int x = fields.x0; x < fields.x1; ++x) {
+           std::size_t index = static_cast<std::size_t>(y) * size + x;
+           fields.elevation[index] = std::clamp(fields.elevation[index] * activeParams.roughness, -1.0f, 1.0f);
+           fields.moisture[index] = (fields.moisture[index] + 1.0f) * 0.5f;
+       }
    }
-   
-   e *= params.roughness;
-   return std::clamp(e, -1.0f, 1.0f);
 }
 
-float LocalMapGenerator::generateMoisture(int x, int y, const GenerationParams& params) {
-   FastNoiseLite moistureNoise = noise;
-   moistureNoise.SetSeed(1234); // Временный константный сид
-   moistureNoise.SetFrequency(0.015f * params.detailLevel);
+void LocalMapGenerator::classifyTiles(ChunkFields& fields) const {
+   const int size = ChunkedTileMap::CHUNK_SIZE;
+   for (int y = fields.y0; y < fields.y1; ++y) {
+       for (int x = fields.x0; x < fields.x1; ++x) {
+           std::size_t index = static_cast<std::size_t>(y) * size + x;
+           fields.types[index] = determineTileType(fields.elevation[index], fields.moisture[index], activeTile);
+       }
+   }
+}
 
-   float m = moistureNoise.GetNoise(x * 1.0f, y * 1.0f);
-   return (m + 1.0f) * 0.5f;
+void LocalMapGenerator::assignTiles(TileLayer& cells, const ChunkFields& fields) const {
+   const int size = ChunkedTileMap::CHUNK_SIZE;
+   for (int y = fields.y0; y < fields.y1; ++y) {
+       for (int x = fields.x0; x < fields.x1; ++x) {
+           std::size_t index = static_cast<std::size_t>(y) * size + x;
+           const TypeInfo& info = typeInfos[static_cast<std::size_t>(fields.types[index])];
+           cells.setTile(index, info.data);
+           if (info.hasProperties) {
+               cells.setProperties(index, generateTileProperties(fields.elevation[index], fields.moisture[index], activeTile));
+               cells.setBiome(index, activeTile.biome);
+           }
+       }
+   }
 }
 
 TileType LocalMapGenerator::determineTileType(float elevation, float moisture, 
-                                           const WorldMap::WorldTile& globalTile) {
+                                           const WorldMap::WorldTile& globalTile) const {
     if (elevation < -0.2f) return TileType::WATER;
     
     switch(globalTile.biome) {
@@ -103,53 +170,41 @@ TileType LocalMapGenerator::determineTileType(float elevation, float moisture,
     }
 }
 
-void LocalMapGenerator::setTileProperties(const ExtendedTileComponent* extTile, 
+void LocalMapGenerator::setTileProperties(TileLayer& layer, std::size_t index,
                                     float elevation, float moisture, 
                                     const WorldMap::WorldTile& globalTile) {
-    // Use const_cast to modify properties
-    auto* mutableTile = const_cast<ExtendedTileComponent*>(extTile);
-    if (!mutableTile) return;
-
-    mutableTile->properties.walkable = elevation >= -0.2f;
-    mutableTile->properties.buildable = elevation >= -0.2f && elevation <= 0.7f;
-    mutableTile->properties.elevation = elevation;
-    mutableTile->properties.fertility = std::max(0.0f, moisture * (1.0f - std::abs(elevation)));
-    mutableTile->properties.temperature = globalTile.temperature - (elevation * 10.0f);
-    mutableTile->properties.humidity = (moisture + globalTile.rainfall) * 0.5f;
+    layer.setProperties(index, generateTileProperties(elevation, moisture, globalTile));
 }
 
-void LocalMapGenerator::applyBiomeModifiers(const ExtendedTileComponent* tile, BiomeType biome) {
-    // Use const_cast to modify the tile properties
-    auto* mutableTile = const_cast<ExtendedTileComponent*>(tile);
-    
-    if (!mutableTile) return;
-
+void LocalMapGenerator::applyBiomeModifiers(ChunkedTileMap& map, BiomeType biome) {
     switch(biome) {
         case BiomeType::DESERT:
-            mutableTile->addModifier("temperature", 0.3f);
-            mutableTile->addModifier("fertility", -0.4f);
+            map.addModifier(biome, "temperature", 0.3f);
+            map.addModifier(biome, "fertility", -0.4f);
             break;
         case BiomeType::TROPICAL:
-            mutableTile->addModifier("fertility", 0.2f);
-            mutableTile->addModifier("humidity", 0.3f);
+            map.addModifier(biome, "fertility", 0.2f);
+            map.addModifier(biome, "humidity", 0.3f);
             break;
         case BiomeType::TUNDRA:
-            mutableTile->addModifier("temperature", -0.3f);
-            mutableTile->addModifier("fertility", -0.2f);
+            map.addModifier(biome, "temperature", -0.3f);
+            map.addModifier(biome, "fertility", -0.2f);
             break;
         case BiomeType::BOREAL:
-            mutableTile->addModifier("temperature", -0.1f);
-            mutableTile->addModifier("humidity", 0.1f);
+            map.addModifier(biome, "temperature", -0.1f);
+            map.addModifier(biome, "humidity", 0.1f);
             break;
         case BiomeType::SAVANNA:
-            mutableTile->addModifier("temperature", 0.2f);
-            mutableTile->addModifier("humidity", -0.2f);
+            map.addModifier(biome, "temperature", 0.2f);
+            map.addModifier(biome, "humidity", -0.2f);
+            break;
+        default:
             break;
     }
 }
 
 TileProperties LocalMapGenerator::generateTileProperties(float elevation, float moisture, 
-                                                      WorldMap::WorldTile& globalTile) {
+                                                      const WorldMap::WorldTile& globalTile) const {
    TileProperties props;
    
    props.elevation = elevation;
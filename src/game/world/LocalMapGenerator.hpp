@@ -1,12 +1,13 @@
 #pragma once
 #include "WorldMap.hpp"
-#include "../../engine/ecs/World.hpp"
+#include "../../engine/core/BatchNoise.hpp"
 #include "../../engine/core/ResourceCache.hpp"
-#include "../../engine/ecs/systems/TileSystem.hpp"
 #include "TileRegistry.hpp"
 #include "BiomeType.hpp"
-#include "ExtendedTileComponent.hpp"
-#include <FastNoiseLite.h>
+#include "ChunkedTileMap.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
 
 namespace game {
     class LocalMapGenerator {
@@ -22,27 +23,98 @@ namespace game {
         LocalMapGenerator(engine::ResourceCache& resourceCache, TileRegistry& tileRegistry) 
             : resourceCache(resourceCache), tileRegistry(tileRegistry) {}
 
-        void generateMap(engine::World& world, 
-                        engine::TileSystem& tileSystem,
+        // Подготовка к генерации новой карты (главный поток): сбрасывает map под
+        // width x height, настраивает шум и один раз на тип получает TileData
+        // (текстуры грузятся здесь), задаёт текстуры и модификаторы биома.
+        // Не вызывать, пока идёт generateChunk() в других потоках.
+        void beginMap(ChunkedTileMap& map,
+                     const WorldMap::WorldTile& globalTile,
+                     const GenerationParams& params = GenerationParams());
+
+        // Заполняет клетки чанка, попадающие в границы карты. После beginMap()
+        // только читает состояние генератора, поэтому безопасна из рабочих потоков.
+        // Шум берётся в мировых координатах, так что соседние чанки стыкуются.
+        //
+        // Этапы - отдельные проходы по массивам чанка: поля шума (высота,
+        // влажность), классификация типов, запись тайлов и свойств. Каждая
+        // клетка зависит только от своих координат и параметров карты, так что
+        // результат не зависит от того, в каком потоке и порядке идут чанки.
+        void generateChunk(TileChunk& chunk) const;
+
+        // Чанк (chunkX, chunkY) мира с сидом seed целиком, без границ карты:
+        // координаты любые, в том числе отрицательные. Результат зависит только
+        // от seed, координат чанка и настроек последнего beginMap() (детализация,
+        // шероховатость, биом) - не от порядка вызовов и потока, так что чанки
+        // можно генерировать лениво, параллельно и в любом порядке. Шум берётся
+        // в мировых координатах, поэтому соседние чанки стыкуются без швов, а
+        // в границах карты с тем же сидом чанк совпадает с generateMap().
+        // До первого beginMap() типам тайлов не из чего взяться - бросает
+        // std::runtime_error.
+        std::unique_ptr<TileChunk> generateChunk(std::uint32_t seed, int chunkX, int chunkY) const;
+
+        // Параметры последнего beginMap(), seed уже выбран
+        const GenerationParams& getParams() const { return activeParams; }
+
+        // beginMap() и генерация всех чанков карты сразу: чанки генерируются
+        // параллельно (OpenMP), вставляются по порядку. Карта побитово та же
+        // при любом числе потоков
+        void generateMap(ChunkedTileMap& map,
                         const WorldMap::WorldTile& globalTile,
                         const GenerationParams& params = GenerationParams());
         
-        void applyBiomeModifiers(const ExtendedTileComponent* tile, BiomeType biome);
+        void applyBiomeModifiers(ChunkedTileMap& map, BiomeType biome);
 
-        void setTileProperties(const ExtendedTileComponent* extTile, 
+        void setTileProperties(TileLayer& layer, std::size_t index,
                             float elevation, float moisture, 
                             const WorldMap::WorldTile& globalTile);
 
     private:
         engine::ResourceCache& resourceCache;
         TileRegistry& tileRegistry;
-        FastNoiseLite noise;
+        // Шум мира с одним сидом: высота - 4 октавы, влажность - одна
+        struct Noise {
+            engine::BatchNoise elevation;
+            engine::BatchNoise moisture;
+        };
+        // Шум сида текущей карты, задаётся в beginMap()
+        Noise mapNoise = makeNoise(0, 1.0f);
+
+        // Состояние текущей карты, заданное beginMap()
+        struct TypeInfo {
+            TileData data;
+            bool hasProperties = false;
+        };
+        std::array<TypeInfo, TILE_TYPE_COUNT> typeInfos;
+        GenerationParams activeParams;
+        WorldMap::WorldTile activeTile;
+        bool mapBegun = false;
+
+        static constexpr std::size_t CHUNK_CELLS = std::size_t(ChunkedTileMap::CHUNK_SIZE) * ChunkedTileMap::CHUNK_SIZE;
+
+        // Промежуточные поля одного чанка между этапами generateChunk()
+        struct ChunkFields {
+            // Клетки чанка в границах карты: [x0, x1) x [y0, y1) в координатах чанка
+            int x0 = 0;
+            int y0 = 0;
+            int x1 = 0;
+            int y1 = 0;
+            std::array<float, CHUNK_CELLS> elevation;
+            std::array<float, CHUNK_CELLS> moisture;
+            std::array<TileType, CHUNK_CELLS> types;
+        };
+
+        static Noise makeNoise(std::uint32_t seed, float detailLevel);
+
+        // Этапы generateChunk(); clipToMap - только клетки в границах карты
+        void generateCells(TileChunk& chunk, const Noise& noise, bool clipToMap) const;
+        void generateNoiseFields(const TileLayer& cells, const Noise& noise, bool clipToMap,
+                                 ChunkFields& fields) const;
+        void classifyTiles(ChunkFields& fields) const;
+        void assignTiles(TileLayer& cells, const ChunkFields& fields) const;
 
         // Вспомогательные методы генерации
-        float generateElevation(int x, int y, const GenerationParams& params);
-        float generateMoisture(int x, int y, const GenerationParams& params);
-        TileType determineTileType(float elevation, float moisture, const WorldMap::WorldTile& globalTile);
+        TileType determineTileType(float elevation, float moisture, const WorldMap::WorldTile& globalTile) const;
         TileProperties generateTileProperties(float elevation, float moisture, 
-                                           WorldMap::WorldTile& globalTile);
+                                           const WorldMap::WorldTile& globalTile) const;
     };
 }
\ No newline at end of file
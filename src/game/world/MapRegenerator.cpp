@@ -0,0 +1,152 @@
+#include "MapRegenerator.hpp"
+#include <algorithm>
+#include <random>
+
+namespace game {
+
+MapRegenerator::MapRegenerator(engine::ResourceCache& resourceCache, TileRegistry& tileRegistry,
+                               engine::ThreadPool& threadPool, Settings settings)
+    : resourceCache(resourceCache), tileRegistry(tileRegistry), threadPool(threadPool), settings(settings) {
+}
+
+MapRegenerator::~MapRegenerator() {
+    // Задачи держат состояние сами, но генератор и текстуры освобождаем здесь;
+    // отменённые задачи заканчиваются быстро
+    cancel();
+    for (Generation& generation : cancelled) {
+        isFinished(generation, true);
+        generation.job->result.reset();
+    }
+}
+
+void MapRegenerator::start(const LocalMapGenerator::GenerationParams& params,
+                           const GridPosition& viewMin, const GridPosition& viewMax) {
+    cancel();
+
+    auto job = std::make_shared<Job>();
+    job->result = std::make_unique<Result>();
+    Result& result = *job->result;
+    result.params = params;
+    // Сид фиксируется сразу - глобальная и локальная карты строятся по одному
+    if (result.params.seed == 0) {
+        result.params.seed = std::random_device{}();
+    }
+    result.worldMap = std::make_unique<WorldMap>(settings.worldWidth, settings.worldHeight);
+
+    // Чанки области обзора в границах карты, ближайшие к центру - первыми
+    if (params.width > 0 && params.height > 0) {
+        GridPosition low(std::clamp(std::min(viewMin.x, viewMax.x), 0, params.width - 1),
+                         std::clamp(std::min(viewMin.y, viewMax.y), 0, params.height - 1));
+        GridPosition high(std::clamp(std::max(viewMin.x, viewMax.x), 0, params.width - 1),
+                          std::clamp(std::max(viewMin.y, viewMax.y), 0, params.height - 1));
+        auto first = ChunkedTileMap::chunkOf(low), last = ChunkedTileMap::chunkOf(high);
+        for (int chunkY = first.y; chunkY <= last.y; ++chunkY) {
+            for (int chunkX = first.x; chunkX <= last.x; ++chunkX) {
+                job->chunkCoords.push_back({chunkX, chunkY});
+            }
+        }
+        // Центр в удвоенных координатах, чтобы остаться в целых
+        const int centerX = first.x + last.x, centerY = first.y + last.y;
+        using Coord = ChunkedTileMap::ChunkCoord;
+        std::sort(job->chunkCoords.begin(), job->chunkCoords.end(), [&](const Coord& a, const Coord& b) {
+            long long ax = 2 * a.x - centerX, ay = 2 * a.y - centerY;
+            long long bx = 2 * b.x - centerX, by = 2 * b.y - centerY;
+            return ax * ax + ay * ay < bx * bx + by * by;
+        });
+        if (job->chunkCoords.size() > settings.maxChunks) {
+            job->chunkCoords.resize(settings.maxChunks);
+        }
+    }
+
+    current = std::make_unique<Generation>();
+    current->job = job;
+    const std::uint32_t seed = result.params.seed;
+    current->worldDone = threadPool.submit([job, seed]() {
+        if (job->cancelled) return;
+        job->result->worldMap->generate(seed);
+    });
+}
+
+void MapRegenerator::cancel() {
+    if (!current) return;
+    current->job->cancelled = true;
+    cancelled.push_back(std::move(*current));
+    current.reset();
+}
+
+std::unique_ptr<MapRegenerator::Result> MapRegenerator::update() {
+    // Последняя ссылка на отменённую генерацию может уйти в рабочем потоке,
+    // поэтому генератор и карту с текстурами отпускаем здесь
+    cancelled.erase(std::remove_if(cancelled.begin(), cancelled.end(), [](Generation& generation) {
+                        if (!isFinished(generation, false)) return false;
+                        generation.job->result.reset();
+                        return true;
+                    }),
+                    cancelled.end());
+
+    if (!current) return nullptr;
+    if (!current->chunksStarted) {
+        if (!engine::isReady(current->worldDone)) return nullptr;
+        current->worldDone.get();
+        startChunks(*current);
+    }
+    if (!isFinished(*current, false)) return nullptr;
+
+    // Все задачи закончились - чанки и результат принадлежат только нам
+    for (auto& done : current->chunksDone) {
+        done.get();
+    }
+    Job& job = *current->job;
+    for (auto& chunk : job.chunks) {
+        job.result->map.insertChunk(std::move(chunk));
+    }
+    std::unique_ptr<Result> ready = std::move(job.result);
+    current.reset();
+    return ready;
+}
+
+float MapRegenerator::getProgress() const {
+    if (!current) return 0.0f;
+    // Глобальная карта - один шаг, каждый чанк - ещё по шагу
+    const Job& job = *current->job;
+    std::size_t total = 1 + job.chunkCoords.size();
+    std::size_t done = (current->chunksStarted ? 1 : 0) + job.completedChunks.load();
+    return static_cast<float>(done) / static_cast<float>(total);
+}
+
+void MapRegenerator::startChunks(Generation& generation) {
+    std::shared_ptr<Job> job = generation.job;
+    Result& result = *job->result;
+    const WorldMap& worldMap = *result.worldMap;
+    result.globalTile = worldMap.getTile(worldMap.getWidth() / 2, worldMap.getHeight() / 2);
+    // Текстуры типов грузятся здесь, на главном потоке
+    result.generator = std::make_unique<LocalMapGenerator>(resourceCache, tileRegistry);
+    result.generator->beginMap(result.map, result.globalTile, result.params);
+
+    job->chunks.resize(job->chunkCoords.size());
+    for (std::size_t i = 0; i < job->chunkCoords.size(); ++i) {
+        generation.chunksDone.push_back(threadPool.submit([job, i]() {
+            if (job->cancelled) return;
+            const ChunkedTileMap::ChunkCoord& coord = job->chunkCoords[i];
+            auto chunk = ChunkedTileMap::makeChunk(coord.x, coord.y);
+            job->result->generator->generateChunk(*chunk);
+            job->chunks[i] = std::move(chunk);
+            ++job->completedChunks;
+        }));
+    }
+    generation.chunksStarted = true;
+}
+
+bool MapRegenerator::isFinished(Generation& generation, bool wait) {
+    if (!generation.chunksStarted) {
+        if (!wait && !engine::isReady(generation.worldDone)) return false;
+        generation.worldDone.wait();
+    }
+    for (auto& done : generation.chunksDone) {
+        if (!wait && !engine::isReady(done)) return false;
+        done.wait();
+    }
+    return true;
+}
+
+} // namespace game
@@ -0,0 +1,104 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <vector>
+#include "ChunkedTileMap.hpp"
+#include "LocalMapGenerator.hpp"
+#include "TileRegistry.hpp"
+#include "WorldMap.hpp"
+#include "../../engine/core/ResourceCache.hpp"
+#include "../../engine/core/ThreadPool.hpp"
+
+namespace game {
+    // Перегенерация мира в фоне: глобальная карта и чанки вокруг области
+    // обзора строятся в пуле потоков в отдельной карте, а прежняя всё это
+    // время остаётся на экране. Готовая карта отдаётся из update() целиком -
+    // главный поток подменяет её за один шаг (ChunkedTileMap::replaceWith).
+    //
+    // Этапы: WorldMap::generate() в пуле; beginMap() нового генератора на
+    // главном потоке (текстуры грузятся там); чанки - по задаче на чанк.
+    // Остальные чанки потом по мере движения камеры догенерирует
+    // ChunkStreamer тем же генератором.
+    //
+    // cancel() и новый start() не ждут задач: те видят флаг отмены и
+    // завершаются сразу. Отменённая генерация освобождается в update() на
+    // главном потоке, когда её задачи закончатся, - в ней есть текстуры.
+    class MapRegenerator {
+    public:
+        struct Settings {
+            int worldWidth = 50;
+            int worldHeight = 50;
+            // Сколько чанков вокруг области обзора сгенерировать до подмены;
+            // ближайшие к центру - первыми
+            std::size_t maxChunks = 256;
+        };
+
+        // Новая карта, готовая к подмене
+        struct Result {
+            std::unique_ptr<WorldMap> worldMap;
+            // Тайл глобальной карты, по которому построена локальная
+            WorldMap::WorldTile globalTile;
+            LocalMapGenerator::GenerationParams params;
+            // После beginMap(); источник остальных чанков для ChunkStreamer
+            std::unique_ptr<LocalMapGenerator> generator;
+            // Текстуры, модификаторы и сгенерированные чанки
+            ChunkedTileMap map;
+        };
+
+        MapRegenerator(engine::ResourceCache& resourceCache, TileRegistry& tileRegistry,
+                       engine::ThreadPool& threadPool, Settings settings);
+        MapRegenerator(engine::ResourceCache& resourceCache, TileRegistry& tileRegistry,
+                       engine::ThreadPool& threadPool)
+            : MapRegenerator(resourceCache, tileRegistry, threadPool, Settings()) {}
+        ~MapRegenerator();
+
+        MapRegenerator(const MapRegenerator&) = delete;
+        MapRegenerator& operator=(const MapRegenerator&) = delete;
+
+        // Начинает генерацию с params (seed 0 - случайный); идущая
+        // отменяется. Заранее генерируются чанки области обзора [viewMin, viewMax]
+        void start(const LocalMapGenerator::GenerationParams& params,
+                   const GridPosition& viewMin, const GridPosition& viewMax);
+
+        void cancel();
+
+        // Раз в кадр на главном потоке: продвигает этапы; когда карта готова,
+        // возвращает её (один раз), иначе nullptr
+        std::unique_ptr<Result> update();
+
+        bool isRunning() const { return current != nullptr; }
+        // Доля выполненной работы, 0..1
+        float getProgress() const;
+
+    private:
+        // Общее с задачами в пуле
+        struct Job {
+            std::atomic<bool> cancelled{false};
+            std::unique_ptr<Result> result;
+            std::vector<ChunkedTileMap::ChunkCoord> chunkCoords;
+            std::vector<std::unique_ptr<TileChunk>> chunks;
+            std::atomic<std::size_t> completedChunks{0};
+        };
+
+        // future задач держит только главный поток: внутри Job они замкнули
+        // бы задачи сами на себя
+        struct Generation {
+            std::shared_ptr<Job> job;
+            std::future<void> worldDone;
+            std::vector<std::future<void>> chunksDone;
+            bool chunksStarted = false;
+        };
+
+        engine::ResourceCache& resourceCache;
+        TileRegistry& tileRegistry;
+        engine::ThreadPool& threadPool;
+        Settings settings;
+        std::unique_ptr<Generation> current;
+        std::vector<Generation> cancelled;
+
+        void startChunks(Generation& generation);
+        static bool isFinished(Generation& generation, bool wait);
+    };
+}
@@ -0,0 +1,732 @@
+#include "PathFinder.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+
+namespace game {
+
+namespace {
+    constexpr int SIZE = ChunkedTileMap::CHUNK_SIZE;
+    constexpr int MASK = ChunkedTileMap::CHUNK_MASK;
+    constexpr float DIAGONAL_COST = 1.41421356f;
+    constexpr float INF = std::numeric_limits<float>::infinity();
+    // Проём такой длины и больше получает два входа (по краям), короче - один
+    constexpr int LONG_ENTRANCE = 6;
+
+    enum Side { RIGHT, LEFT, DOWN, UP };
+
+    float octile(int dx, int dy) {
+        dx = std::abs(dx);
+        dy = std::abs(dy);
+        return static_cast<float>(std::max(dx, dy)) + (DIAGONAL_COST - 1.0f) * static_cast<float>(std::min(dx, dy));
+    }
+
+    float octile(const GridPosition& a, const GridPosition& b) {
+        return octile(a.x - b.x, a.y - b.y);
+    }
+
+    void pushHeap(std::vector<PathFinder::HeapItem>& heap, float f, std::int32_t node) {
+        heap.push_back({f, node});
+        std::push_heap(heap.begin(), heap.end(), std::greater<PathFinder::HeapItem>());
+    }
+
+    PathFinder::HeapItem popHeap(std::vector<PathFinder::HeapItem>& heap) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<PathFinder::HeapItem>());
+        PathFinder::HeapItem item = heap.back();
+        heap.pop_back();
+        return item;
+    }
+
+    // Новая «эпоха» меток: всё, что помечено другой меткой, считается не посещённым
+    void beginSearch(PathFinder::Scratch& scratch, std::size_t nodeCount) {
+        if (scratch.stamp.size() < nodeCount) {
+            scratch.stamp.resize(nodeCount, 0);
+            scratch.cost.resize(nodeCount);
+            scratch.parent.resize(nodeCount);
+        }
+        if (++scratch.currentStamp == 0) {
+            std::fill(scratch.stamp.begin(), scratch.stamp.end(), 0u);
+            scratch.currentStamp = 1;
+        }
+        scratch.heap.clear();
+    }
+
+    // Прыжки JPS по локальной сетке без срезания углов. Сетка окружена
+    // рамкой непроходимых клеток, так что x и y от -1 до width/height
+    // читаются без проверок границ
+    struct JumpGrid {
+        const std::uint8_t* cells;
+        int width;
+        int height;
+        int goalX;
+        int goalY;
+
+        int index(int x, int y) const { return (y + 1) * (width + 2) + x + 1; }
+
+        bool walkable(int x, int y) const { return cells[index(x, y)] != 0; }
+
+        int jumpStraight(int x, int y, int dx, int dy) const {
+            for (;; x += dx, y += dy) {
+                if (!walkable(x, y)) return -1;
+                if (x == goalX && y == goalY) return index(x, y);
+                if (dx != 0) {
+                    if ((walkable(x, y - 1) && !walkable(x - dx, y - 1)) ||
+                        (walkable(x, y + 1) && !walkable(x - dx, y + 1))) {
+                        return index(x, y);
+                    }
+                } else if ((walkable(x - 1, y) && !walkable(x - 1, y - dy)) ||
+                           (walkable(x + 1, y) && !walkable(x + 1, y - dy))) {
+                    return index(x, y);
+                }
+            }
+        }
+
+        int jump(int x, int y, int dx, int dy) const {
+            if (dx == 0 || dy == 0) {
+                return jumpStraight(x, y, dx, dy);
+            }
+            for (;; x += dx, y += dy) {
+                if (!walkable(x, y)) return -1;
+                if (x == goalX && y == goalY) return index(x, y);
+                if (jumpStraight(x + dx, y, dx, 0) >= 0 || jumpStraight(x, y + dy, 0, dy) >= 0) {
+                    return index(x, y);
+                }
+                if (!walkable(x + dx, y) || !walkable(x, y + dy)) return -1;
+            }
+        }
+
+        // Направления, которые стоит проверять из (x, y) при приходе из parent
+        int successors(int x, int y, int parent, int (&directions)[8][2]) const {
+            int count = 0;
+            auto add = [&](int dx, int dy) {
+                directions[count][0] = dx;
+                directions[count][1] = dy;
+                ++count;
+            };
+            if (parent < 0) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        if (dx == 0 && dy == 0) continue;
+                        if (dx != 0 && dy != 0 && (!walkable(x + dx, y) || !walkable(x, y + dy))) continue;
+                        add(dx, dy);
+                    }
+                }
+                return count;
+            }
+
+            int px = parent % (width + 2) - 1, py = parent / (width + 2) - 1;
+            int dx = (x > px) - (x < px), dy = (y > py) - (y < py);
+            if (dx != 0 && dy != 0) {
+                bool vertical = walkable(x, y + dy), horizontal = walkable(x + dx, y);
+                if (vertical) add(0, dy);
+                if (horizontal) add(dx, 0);
+                if (vertical && horizontal) add(dx, dy);
+            } else if (dx != 0) {
+                bool next = walkable(x + dx, y), below = walkable(x, y + 1), above = walkable(x, y - 1);
+                if (next) {
+                    add(dx, 0);
+                    if (below) add(dx, 1);
+                    if (above) add(dx, -1);
+                }
+                if (below) add(0, 1);
+                if (above) add(0, -1);
+            } else {
+                bool next = walkable(x, y + dy), right = walkable(x + 1, y), left = walkable(x - 1, y);
+                if (next) {
+                    add(0, dy);
+                    if (right) add(1, dy);
+                    if (left) add(-1, dy);
+                }
+                if (right) add(1, 0);
+                if (left) add(-1, 0);
+            }
+            return count;
+        }
+    };
+}
+
+int PathFinder::ChunkGraph::findNode(int cell) const {
+    auto it = std::lower_bound(nodes.begin(), nodes.end(), static_cast<std::uint16_t>(cell));
+    return it != nodes.end() && *it == cell ? static_cast<int>(it - nodes.begin()) : -1;
+}
+
+const PathFinder::ChunkGraph* PathFinder::findGraph(int chunkX, int chunkY) const {
+    auto it = graphs.find(ChunkedTileMap::chunkKey(chunkX, chunkY));
+    return it != graphs.end() ? &it->second : nullptr;
+}
+
+PathFinder::ChunkGraph* PathFinder::findGraph(int chunkX, int chunkY) {
+    auto it = graphs.find(ChunkedTileMap::chunkKey(chunkX, chunkY));
+    return it != graphs.end() ? &it->second : nullptr;
+}
+
+PathFinder::PathFinder(const PathFinder& other)
+    : regions(other.regions), settings(other.settings), syncedMap(other.syncedMap),
+      syncedMapVersion(other.syncedMapVersion), version(other.version), graphs(other.graphs) {
+    // Указатели скопированных графов смотрят в чужую таблицу
+    for (auto& [graphKey, graph] : graphs) {
+        linkNeighbors(graph);
+    }
+    renumberNodes();
+}
+
+std::shared_ptr<const PathFinder> PathFinder::snapshot() const {
+    auto copy = std::make_shared<PathFinder>(*this);
+    copy->regions = nullptr;
+    return copy;
+}
+
+void PathFinder::update(const ChunkedTileMap& map) {
+    changedChunks.clear();
+    if (syncedMap != &map) {
+        graphs.clear();
+        syncedMap = &map;
+        syncedMapVersion = map.getVersion();
+    } else if (syncedMapVersion != map.getVersion()) {
+        for (auto it = graphs.begin(); it != graphs.end();) {
+            const TileChunk* chunk = map.findChunk(it->second.chunkX, it->second.chunkY);
+            if (!chunk || chunk->serial != it->second.serial) {
+                changedChunks.emplace_back(it->second.chunkX, it->second.chunkY);
+                it = graphs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        syncedMapVersion = map.getVersion();
+    }
+
+    map.forEachChunk([&](const TileChunk& chunk) {
+        ChunkGraph& graph = graphs[ChunkedTileMap::chunkKey(chunk.chunkX, chunk.chunkY)];
+        if (graph.serial != chunk.serial || graph.version != chunk.cells.getVersion()) {
+            graph.chunkX = chunk.chunkX;
+            graph.chunkY = chunk.chunkY;
+            graph.serial = chunk.serial;
+            graph.version = chunk.cells.getVersion();
+            for (int y = 0; y < SIZE; ++y) {
+                graph.walkable[y] = chunk.bits.row(TileBitmaps::WALKABLE, y);
+            }
+            changedChunks.emplace_back(chunk.chunkX, chunk.chunkY);
+        }
+    });
+    if (changedChunks.empty()) return;
+
+    std::sort(changedChunks.begin(), changedChunks.end());
+    changedChunks.erase(std::unique(changedChunks.begin(), changedChunks.end()), changedChunks.end());
+
+    // Входы на всех четырёх границах изменившихся чанков
+    for (const auto& [chunkX, chunkY] : changedChunks) {
+        if (ChunkGraph* graph = findGraph(chunkX, chunkY)) {
+            computeTransitions(*graph, true);
+            computeTransitions(*graph, false);
+        }
+        if (ChunkGraph* left = findGraph(chunkX - 1, chunkY)) {
+            computeTransitions(*left, true);
+        }
+        if (ChunkGraph* up = findGraph(chunkX, chunkY - 1)) {
+            computeTransitions(*up, false);
+        }
+    }
+
+    // Узлы и расстояния - у них и у соседей, чьи границы могли измениться
+    dirtyGraphs.clear();
+    for (const auto& [chunkX, chunkY] : changedChunks) {
+        const int offsets[5][2] = {{0, 0}, {1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+        for (const auto& offset : offsets) {
+            if (ChunkGraph* graph = findGraph(chunkX + offset[0], chunkY + offset[1])) {
+                dirtyGraphs.push_back(graph);
+            }
+        }
+    }
+    std::sort(dirtyGraphs.begin(), dirtyGraphs.end());
+    dirtyGraphs.erase(std::unique(dirtyGraphs.begin(), dirtyGraphs.end()), dirtyGraphs.end());
+    for (ChunkGraph* graph : dirtyGraphs) {
+        computeNodes(*graph);
+    }
+
+    renumberNodes();
+    ++version;
+}
+
+void PathFinder::computeTransitions(ChunkGraph& first, bool horizontal) {
+    std::vector<std::uint8_t>& transitions = horizontal ? first.rightTransitions : first.downTransitions;
+    transitions.clear();
+    const ChunkGraph* second = horizontal ? findGraph(first.chunkX + 1, first.chunkY)
+                                          : findGraph(first.chunkX, first.chunkY + 1);
+    if (!second) return;
+
+    // Бит i - клетка i вдоль границы проходима с обеих сторон
+    std::uint32_t open = 0;
+    if (horizontal) {
+        for (int i = 0; i < SIZE; ++i) {
+            if (first.isWalkable(SIZE - 1, i) && second->isWalkable(0, i)) {
+                open |= 1u << i;
+            }
+        }
+    } else {
+        open = first.walkable[SIZE - 1] & second->walkable[0];
+    }
+
+    while (open) {
+        int begin = TileBitmaps::lowestBit(open);
+        std::uint32_t rest = ~open & ~((1u << begin) - 1);
+        int end = rest ? TileBitmaps::lowestBit(rest) - 1 : SIZE - 1;
+        open &= rest ? ~((1u << (end + 1)) - 1) : 0;
+
+        if (end - begin + 1 >= LONG_ENTRANCE) {
+            transitions.push_back(static_cast<std::uint8_t>(begin));
+            transitions.push_back(static_cast<std::uint8_t>(end));
+        } else {
+            transitions.push_back(static_cast<std::uint8_t>((begin + end) / 2));
+        }
+    }
+}
+
+void PathFinder::linkNeighbors(ChunkGraph& graph) {
+    graph.neighbors[RIGHT] = findGraph(graph.chunkX + 1, graph.chunkY);
+    graph.neighbors[LEFT] = findGraph(graph.chunkX - 1, graph.chunkY);
+    graph.neighbors[DOWN] = findGraph(graph.chunkX, graph.chunkY + 1);
+    graph.neighbors[UP] = findGraph(graph.chunkX, graph.chunkY - 1);
+}
+
+void PathFinder::computeNodes(ChunkGraph& graph) {
+    linkNeighbors(graph);
+
+    graph.nodes.clear();
+    for (std::uint8_t i : graph.rightTransitions) {
+        graph.nodes.push_back(static_cast<std::uint16_t>(i * SIZE + SIZE - 1));
+    }
+    for (std::uint8_t i : graph.downTransitions) {
+        graph.nodes.push_back(static_cast<std::uint16_t>((SIZE - 1) * SIZE + i));
+    }
+    if (const ChunkGraph* left = graph.neighbors[LEFT]) {
+        for (std::uint8_t i : left->rightTransitions) {
+            graph.nodes.push_back(static_cast<std::uint16_t>(i * SIZE));
+        }
+    }
+    if (const ChunkGraph* up = graph.neighbors[UP]) {
+        for (std::uint8_t i : up->downTransitions) {
+            graph.nodes.push_back(static_cast<std::uint16_t>(i));
+        }
+    }
+    std::sort(graph.nodes.begin(), graph.nodes.end());
+    graph.nodes.erase(std::unique(graph.nodes.begin(), graph.nodes.end()), graph.nodes.end());
+
+    const std::size_t count = graph.nodes.size();
+    graph.distances.assign(count * count, INF);
+    for (std::size_t i = 0; i < count; ++i) {
+        chunkDistances(graph, graph.nodes[i], buildDistances, buildHeap, &graph.nodes);
+        for (std::size_t j = 0; j < count; ++j) {
+            graph.distances[i * count + j] = buildDistances[graph.nodes[j]];
+        }
+    }
+}
+
+void PathFinder::renumberNodes() {
+    nodeOwner.clear();
+    for (auto& [graphKey, graph] : graphs) {
+        graph.firstNode = static_cast<std::uint32_t>(nodeOwner.size());
+        for (std::size_t i = 0; i < graph.nodes.size(); ++i) {
+            nodeOwner.push_back({&graph, static_cast<std::uint16_t>(i)});
+        }
+    }
+}
+
+// Дейкстра от клетки source по клеткам одного чанка. С targets (по
+// возрастанию) останавливается, как только все они получили окончательное
+// расстояние; остальные клетки тогда могут остаться неточными
+void PathFinder::chunkDistances(const ChunkGraph& graph, int source, std::vector<float>& distances,
+                                std::vector<HeapItem>& heap, const std::vector<std::uint16_t>* targets) {
+    distances.assign(SIZE * SIZE, INF);
+    heap.clear();
+    distances[source] = 0.0f;
+    pushHeap(heap, 0.0f, source);
+    std::size_t remaining = targets ? targets->size() : 0;
+
+    while (!heap.empty()) {
+        HeapItem item = popHeap(heap);
+        if (item.f > distances[item.node]) continue;
+        if (targets && std::binary_search(targets->begin(), targets->end(), static_cast<std::uint16_t>(item.node)) &&
+            --remaining == 0) {
+            break;
+        }
+        int x = item.node % SIZE, y = item.node / SIZE;
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (dx == 0 && dy == 0) continue;
+                int nx = x + dx, ny = y + dy;
+                if (nx < 0 || ny < 0 || nx >= SIZE || ny >= SIZE || !graph.isWalkable(nx, ny)) continue;
+                bool diagonal = dx != 0 && dy != 0;
+                if (diagonal && (!graph.isWalkable(nx, y) || !graph.isWalkable(x, ny))) continue;
+                float distance = item.f + (diagonal ? DIAGONAL_COST : 1.0f);
+                int next = ny * SIZE + nx;
+                if (distance < distances[next]) {
+                    distances[next] = distance;
+                    pushHeap(heap, distance, next);
+                }
+            }
+        }
+    }
+}
+
+bool PathFinder::isWalkable(const GridPosition& pos) const {
+    auto coord = ChunkedTileMap::chunkOf(pos);
+    const ChunkGraph* graph = findGraph(coord.x, coord.y);
+    return graph && graph->isWalkable(pos.x & MASK, pos.y & MASK);
+}
+
+GridPosition PathFinder::nodePosition(std::int32_t node, const GridPosition& start, const GridPosition& goal) const {
+    const std::int32_t nodeCount = static_cast<std::int32_t>(nodeOwner.size());
+    if (node == nodeCount) return start;
+    if (node == nodeCount + 1) return goal;
+    const NodeRef& ref = nodeOwner[node];
+    int cell = ref.graph->nodes[ref.index];
+    GridPosition origin = ChunkedTileMap::chunkOrigin(ref.graph->chunkX, ref.graph->chunkY);
+    return GridPosition(origin.x + (cell & MASK), origin.y + (cell >> ChunkedTileMap::CHUNK_SHIFT));
+}
+
+template<typename Func>
+void PathFinder::forEachNeighbor(std::int32_t node, Func&& fn) const {
+    const NodeRef& ref = nodeOwner[node];
+    const ChunkGraph& graph = *ref.graph;
+    const std::size_t count = graph.nodes.size();
+    const float* distances = &graph.distances[ref.index * count];
+    for (std::size_t j = 0; j < count; ++j) {
+        if (j != ref.index && distances[j] != INF) {
+            fn(static_cast<std::int32_t>(graph.firstNode + j), distances[j]);
+        }
+    }
+
+    // Шаг через границу в соседний чанк
+    const int cell = graph.nodes[ref.index];
+    const int x = cell % SIZE, y = cell / SIZE;
+    auto cross = [&](const ChunkGraph* neighbor, int neighborCell) {
+        if (!neighbor) return;
+        int index = neighbor->findNode(neighborCell);
+        if (index >= 0) fn(static_cast<std::int32_t>(neighbor->firstNode + index), 1.0f);
+    };
+    if (x == SIZE - 1) cross(graph.neighbors[RIGHT], y * SIZE);
+    if (x == 0) cross(graph.neighbors[LEFT], y * SIZE + SIZE - 1);
+    if (y == SIZE - 1) cross(graph.neighbors[DOWN], x);
+    if (y == 0) cross(graph.neighbors[UP], (SIZE - 1) * SIZE + x);
+}
+
+float PathFinder::pathLength(const std::vector<GridPosition>& path) {
+    float length = 0.0f;
+    for (std::size_t i = 1; i < path.size(); ++i) {
+        length += octile(path[i - 1], path[i]);
+    }
+    return length;
+}
+
+bool PathFinder::findPath(const GridPosition& start, const GridPosition& goal, std::vector<GridPosition>& path,
+                          Scratch& scratch) const {
+    path.clear();
+    if (!isWalkable(start) || !isWalkable(goal)) return false;
+    if (regions && !regions->canReach(start, goal)) return false;
+    if (start == goal) {
+        path.push_back(start);
+        return true;
+    }
+    return directSearch(start, goal, path, scratch) || hierarchicalSearch(start, goal, path, scratch);
+}
+
+void PathFinder::findPaths(const GridPosition& goal, const std::vector<GridPosition>& starts,
+                           std::vector<std::vector<GridPosition>>& paths, Scratch& scratch) const {
+    paths.assign(starts.size(), {});
+    if (!isWalkable(goal)) return;
+
+    // Первое дальнее начало ищется обычным A*; дерево строится, только если
+    // их больше одного
+    std::size_t firstFar = starts.size();
+    bool treeReady = false;
+    for (std::size_t i = 0; i < starts.size(); ++i) {
+        const GridPosition& start = starts[i];
+        std::vector<GridPosition>& path = paths[i];
+        if (!isWalkable(start)) continue;
+        if (regions && !regions->canReach(start, goal)) continue;
+        if (start == goal) {
+            path.push_back(start);
+            continue;
+        }
+        if (directSearch(start, goal, path, scratch)) continue;
+
+        if (firstFar == starts.size()) {
+            firstFar = i;
+            hierarchicalSearch(start, goal, path, scratch);
+            continue;
+        }
+        if (!treeReady) {
+            if (!buildGoalTree(goal, scratch)) return;
+            treeReady = true;
+        }
+        pathFromTree(start, goal, path, scratch);
+    }
+}
+
+bool PathFinder::directSearch(const GridPosition& start, const GridPosition& goal,
+                              std::vector<GridPosition>& path, Scratch& scratch) const {
+    auto from = ChunkedTileMap::chunkOf(start);
+    auto to = ChunkedTileMap::chunkOf(goal);
+    if (std::max(std::abs(from.x - to.x), std::abs(from.y - to.y)) > settings.directSearchChunks) return false;
+    // Запас в чанк вокруг - чтобы обойти препятствие у края
+    return jumpPointSearch(std::min(from.x, to.x) - 1, std::min(from.y, to.y) - 1,
+                           std::max(from.x, to.x) + 1, std::max(from.y, to.y) + 1,
+                           start, goal, path, scratch);
+}
+
+bool PathFinder::jumpPointSearch(int minChunkX, int minChunkY, int maxChunkX, int maxChunkY,
+                                 const GridPosition& start, const GridPosition& goal,
+                                 std::vector<GridPosition>& path, Scratch& scratch) const {
+    path.clear();
+    // Копия маски WALKABLE прямоугольника чанков, по байту на клетку
+    scratch.gridX = minChunkX * SIZE;
+    scratch.gridY = minChunkY * SIZE;
+    scratch.gridWidth = (maxChunkX - minChunkX + 1) * SIZE;
+    scratch.gridHeight = (maxChunkY - minChunkY + 1) * SIZE;
+    const int stride = scratch.gridWidth + 2;
+    scratch.grid.assign(static_cast<std::size_t>(stride) * (scratch.gridHeight + 2), 0);
+    for (int chunkY = minChunkY; chunkY <= maxChunkY; ++chunkY) {
+        for (int chunkX = minChunkX; chunkX <= maxChunkX; ++chunkX) {
+            const ChunkGraph* graph = findGraph(chunkX, chunkY);
+            if (!graph) continue;
+            for (int y = 0; y < SIZE; ++y) {
+                std::uint32_t word = graph->walkable[y];
+                std::uint8_t* row = &scratch.grid[static_cast<std::size_t>((chunkY - minChunkY) * SIZE + y + 1) * stride +
+                                                  (chunkX - minChunkX) * SIZE + 1];
+                for (int x = 0; x < SIZE; ++x) {
+                    row[x] = (word >> x) & 1u;
+                }
+            }
+        }
+    }
+
+    JumpGrid grid{scratch.grid.data(), scratch.gridWidth, scratch.gridHeight,
+                  goal.x - scratch.gridX, goal.y - scratch.gridY};
+    const int startX = start.x - scratch.gridX, startY = start.y - scratch.gridY;
+    auto inside = [&](int x, int y) { return x >= 0 && y >= 0 && x < grid.width && y < grid.height; };
+    if (!inside(startX, startY) || !inside(grid.goalX, grid.goalY) ||
+        !grid.walkable(startX, startY) || !grid.walkable(grid.goalX, grid.goalY)) {
+        return false;
+    }
+
+    beginSearch(scratch, scratch.grid.size());
+    const int startIndex = grid.index(startX, startY);
+    const int goalIndex = grid.index(grid.goalX, grid.goalY);
+    scratch.stamp[startIndex] = scratch.currentStamp;
+    scratch.cost[startIndex] = 0.0f;
+    scratch.parent[startIndex] = -1;
+    pushHeap(scratch.heap, octile(startX - grid.goalX, startY - grid.goalY), startIndex);
+
+    int directions[8][2];
+    while (!scratch.heap.empty()) {
+        HeapItem item = popHeap(scratch.heap);
+        const int node = item.node;
+        const int x = node % stride - 1, y = node / stride - 1;
+        const float cost = scratch.cost[node];
+        if (item.f > cost + octile(x - grid.goalX, y - grid.goalY) + 1e-3f) continue;
+
+        if (node == goalIndex) {
+            for (int current = goalIndex; current >= 0; current = scratch.parent[current]) {
+                path.emplace_back(scratch.gridX + current % stride - 1, scratch.gridY + current / stride - 1);
+            }
+            std::reverse(path.begin(), path.end());
+            return true;
+        }
+
+        int count = grid.successors(x, y, scratch.parent[node], directions);
+        for (int i = 0; i < count; ++i) {
+            int jumpPoint = grid.jump(x + directions[i][0], y + directions[i][1], directions[i][0], directions[i][1]);
+            if (jumpPoint < 0) continue;
+            int jx = jumpPoint % stride - 1, jy = jumpPoint / stride - 1;
+            float next = cost + octile(jx - x, jy - y);
+            if (scratch.stamp[jumpPoint] != scratch.currentStamp || next < scratch.cost[jumpPoint]) {
+                scratch.stamp[jumpPoint] = scratch.currentStamp;
+                scratch.cost[jumpPoint] = next;
+                scratch.parent[jumpPoint] = node;
+                pushHeap(scratch.heap, next + octile(jx - grid.goalX, jy - grid.goalY), jumpPoint);
+            }
+        }
+    }
+    return false;
+}
+
+bool PathFinder::hierarchicalSearch(const GridPosition& start, const GridPosition& goal,
+                                    std::vector<GridPosition>& path, Scratch& scratch) const {
+    path.clear();
+    auto from = ChunkedTileMap::chunkOf(start);
+    auto to = ChunkedTileMap::chunkOf(goal);
+    const ChunkGraph* startGraph = findGraph(from.x, from.y);
+    const ChunkGraph* goalGraph = findGraph(to.x, to.y);
+    if (!startGraph || !goalGraph) return false;
+
+    const int startCell = (start.y & MASK) * SIZE + (start.x & MASK);
+    const int goalCell = (goal.y & MASK) * SIZE + (goal.x & MASK);
+    // Если цель в том же чанке, до неё тоже нужно точное расстояние
+    chunkDistances(*startGraph, startCell, scratch.startDistances, scratch.heap,
+                   startGraph == goalGraph ? nullptr : &startGraph->nodes);
+    chunkDistances(*goalGraph, goalCell, scratch.goalDistances, scratch.heap, &goalGraph->nodes);
+
+    // Узлы графа, затем начало и цель как временные узлы
+    const std::int32_t startNode = static_cast<std::int32_t>(nodeOwner.size());
+    const std::int32_t goalNode = startNode + 1;
+    beginSearch(scratch, nodeOwner.size() + 2);
+
+    std::int32_t current = startNode;
+    auto relax = [&](std::int32_t next, float cost) {
+        cost += scratch.cost[current];
+        if (scratch.stamp[next] == scratch.currentStamp && cost >= scratch.cost[next]) return;
+        scratch.stamp[next] = scratch.currentStamp;
+        scratch.cost[next] = cost;
+        scratch.parent[next] = current;
+        pushHeap(scratch.heap, cost + octile(nodePosition(next, start, goal), goal), next);
+    };
+
+    scratch.stamp[startNode] = scratch.currentStamp;
+    scratch.cost[startNode] = 0.0f;
+    scratch.parent[startNode] = -1;
+    pushHeap(scratch.heap, octile(start, goal), startNode);
+
+    bool found = false;
+    while (!scratch.heap.empty()) {
+        HeapItem item = popHeap(scratch.heap);
+        current = item.node;
+        if (item.f > scratch.cost[current] + octile(nodePosition(current, start, goal), goal) + 1e-3f) continue;
+        if (current == goalNode) {
+            found = true;
+            break;
+        }
+
+        if (current == startNode) {
+            for (std::size_t i = 0; i < startGraph->nodes.size(); ++i) {
+                float distance = scratch.startDistances[startGraph->nodes[i]];
+                if (distance != INF) relax(static_cast<std::int32_t>(startGraph->firstNode + i), distance);
+            }
+            if (startGraph == goalGraph && scratch.startDistances[goalCell] != INF) {
+                relax(goalNode, scratch.startDistances[goalCell]);
+            }
+            continue;
+        }
+
+        forEachNeighbor(current, relax);
+        const NodeRef& ref = nodeOwner[current];
+        if (ref.graph == goalGraph) {
+            float distance = scratch.goalDistances[ref.graph->nodes[ref.index]];
+            if (distance != INF) relax(goalNode, distance);
+        }
+    }
+    if (!found) return false;
+
+    scratch.abstractPath.clear();
+    for (std::int32_t node = goalNode; node >= 0; node = scratch.parent[node]) {
+        scratch.abstractPath.push_back(node);
+    }
+    std::reverse(scratch.abstractPath.begin(), scratch.abstractPath.end());
+    return refine(start, goal, path, scratch);
+}
+
+// Дейкстра от цели по всему графу: treeCost - расстояние до цели,
+// treeParent - следующий узел на пути к ней (цель - узел nodeCount + 1)
+bool PathFinder::buildGoalTree(const GridPosition& goal, Scratch& scratch) const {
+    auto to = ChunkedTileMap::chunkOf(goal);
+    const ChunkGraph* goalGraph = findGraph(to.x, to.y);
+    if (!goalGraph) return false;
+
+    const int goalCell = (goal.y & MASK) * SIZE + (goal.x & MASK);
+    chunkDistances(*goalGraph, goalCell, scratch.goalDistances, scratch.heap, &goalGraph->nodes);
+
+    const std::int32_t goalNode = static_cast<std::int32_t>(nodeOwner.size()) + 1;
+    scratch.treeCost.assign(nodeOwner.size() + 2, INF);
+    scratch.treeParent.assign(nodeOwner.size() + 2, -1);
+    scratch.heap.clear();
+    scratch.treeCost[goalNode] = 0.0f;
+    for (std::size_t i = 0; i < goalGraph->nodes.size(); ++i) {
+        float distance = scratch.goalDistances[goalGraph->nodes[i]];
+        std::int32_t node = static_cast<std::int32_t>(goalGraph->firstNode + i);
+        if (distance != INF) {
+            scratch.treeCost[node] = distance;
+            scratch.treeParent[node] = goalNode;
+            pushHeap(scratch.heap, distance, node);
+        }
+    }
+
+    while (!scratch.heap.empty()) {
+        HeapItem item = popHeap(scratch.heap);
+        if (item.f > scratch.treeCost[item.node]) continue;
+        forEachNeighbor(item.node, [&](std::int32_t next, float cost) {
+            cost += item.f;
+            if (cost < scratch.treeCost[next]) {
+                scratch.treeCost[next] = cost;
+                scratch.treeParent[next] = item.node;
+                pushHeap(scratch.heap, cost, next);
+            }
+        });
+    }
+    return true;
+}
+
+bool PathFinder::pathFromTree(const GridPosition& start, const GridPosition& goal,
+                              std::vector<GridPosition>& path, Scratch& scratch) const {
+    path.clear();
+    auto from = ChunkedTileMap::chunkOf(start);
+    auto to = ChunkedTileMap::chunkOf(goal);
+    const ChunkGraph* startGraph = findGraph(from.x, from.y);
+    if (!startGraph) return false;
+    const bool sameChunk = from.x == to.x && from.y == to.y;
+
+    const int startCell = (start.y & MASK) * SIZE + (start.x & MASK);
+    chunkDistances(*startGraph, startCell, scratch.startDistances, scratch.heap,
+                   sameChunk ? nullptr : &startGraph->nodes);
+
+    // Лучший вход чанка начала с учётом расстояния от него до цели
+    const std::int32_t startNode = static_cast<std::int32_t>(nodeOwner.size());
+    const std::int32_t goalNode = startNode + 1;
+    float best = INF;
+    std::int32_t bestNode = -1;
+    if (sameChunk) {
+        best = scratch.startDistances[(goal.y & MASK) * SIZE + (goal.x & MASK)];
+        bestNode = goalNode;
+    }
+    for (std::size_t i = 0; i < startGraph->nodes.size(); ++i) {
+        std::int32_t node = static_cast<std::int32_t>(startGraph->firstNode + i);
+        float cost = scratch.startDistances[startGraph->nodes[i]] + scratch.treeCost[node];
+        if (cost < best) {
+            best = cost;
+            bestNode = node;
+        }
+    }
+    if (best == INF) return false;
+
+    scratch.abstractPath.clear();
+    scratch.abstractPath.push_back(startNode);
+    for (std::int32_t node = bestNode; node >= 0; node = scratch.treeParent[node]) {
+        scratch.abstractPath.push_back(node);
+    }
+    return refine(start, goal, path, scratch);
+}
+
+// Внутри чанка - JPS по одному чанку, через границу - один шаг
+bool PathFinder::refine(const GridPosition& start, const GridPosition& goal,
+                        std::vector<GridPosition>& path, Scratch& scratch) const {
+    path.clear();
+    path.push_back(start);
+    for (std::size_t i = 1; i < scratch.abstractPath.size(); ++i) {
+        GridPosition a = path.back();
+        GridPosition b = nodePosition(scratch.abstractPath[i], start, goal);
+        if (a == b) continue;
+        auto chunkA = ChunkedTileMap::chunkOf(a);
+        auto chunkB = ChunkedTileMap::chunkOf(b);
+        if (chunkA.x != chunkB.x || chunkA.y != chunkB.y) {
+            path.push_back(b);
+            continue;
+        }
+        if (!jumpPointSearch(chunkA.x, chunkA.y, chunkA.x, chunkA.y, a, b, scratch.segment, scratch)) {
+            path.clear();
+            return false;
+        }
+        path.insert(path.end(), scratch.segment.begin() + 1, scratch.segment.end());
+    }
+    return true;
+}
+
+} // namespace game
@@ -0,0 +1,185 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ChunkedTileMap.hpp"
+#include "RegionMap.hpp"
+
+namespace game {
+    // Поиск пути по проходимым клеткам загруженной части карты.
+    //
+    // Ходы - в 8 направлениях (прямой стоит 1, диагональный - sqrt(2)), срезать
+    // углы нельзя: диагональ требует обеих прямых клеток. Поэтому связность та
+    // же, что у RegionMap, и её canReach() отсекает недостижимые цели сразу.
+    //
+    // Близкие точки (чанки рядом) соединяются jump point search по локальной
+    // копии маски WALKABLE. Для дальних используется HPA*: чанки - кластеры,
+    // на общих границах соседних чанков выбираются входы (середина короткого
+    // проёма или оба конца длинного), внутри чанка расстояния между входами
+    // считаются заранее. A* по этому графу даёт цепочку входов, а отрезки
+    // внутри чанков уточняются тем же JPS.
+    //
+    // update() пересчитывает граф только для изменившихся чанков и их соседей.
+    // Маска проходимости копируется в граф, так что поиск к карте не
+    // обращается: findPath() константный и с собственным Scratch может
+    // вызываться из нескольких потоков, пока не идёт update(), а snapshot()
+    // даёт неизменяемую копию для рабочих потоков.
+    class PathFinder {
+    public:
+        struct Settings {
+            // Если чанки начала и цели отстоят не больше чем на столько,
+            // путь сначала ищется напрямую JPS
+            int directSearchChunks = 1;
+        };
+
+        struct HeapItem {
+            float f;
+            std::int32_t node;
+            bool operator>(const HeapItem& other) const { return f > other.f; }
+        };
+
+        // Рабочие буферы одного поиска; у каждого потока свои
+        struct Scratch {
+            // Локальная сетка JPS
+            std::vector<std::uint8_t> grid;
+            int gridX = 0;
+            int gridY = 0;
+            int gridWidth = 0;
+            int gridHeight = 0;
+
+            std::vector<float> cost;
+            std::vector<std::int32_t> parent;
+            std::vector<std::uint32_t> stamp;
+            std::uint32_t currentStamp = 0;
+            std::vector<HeapItem> heap;
+
+            // Дерево кратчайших путей к одной цели (findPaths)
+            std::vector<float> treeCost;
+            std::vector<std::int32_t> treeParent;
+
+            std::vector<float> startDistances;
+            std::vector<float> goalDistances;
+            std::vector<std::int32_t> abstractPath;
+            std::vector<GridPosition> segment;
+        };
+
+        PathFinder(const RegionMap* regions, Settings settings)
+            : regions(regions), settings(settings) {}
+        explicit PathFinder(const RegionMap* regions = nullptr)
+            : PathFinder(regions, Settings()) {}
+
+        PathFinder(const PathFinder& other);
+        PathFinder& operator=(const PathFinder&) = delete;
+
+        // После изменений карты (раз в кадр, после RegionMap::update)
+        void update(const ChunkedTileMap& map);
+
+        // Неизменяемая копия графа для поиска в других потоках. RegionMap в
+        // копию не попадает: её проверяет тот, кто раздаёт запросы
+        std::shared_ptr<const PathFinder> snapshot() const;
+
+        // path - опорные точки от start до goal включительно; соседние точки
+        // соединены прямым или диагональным (45°) отрезком
+        bool findPath(const GridPosition& start, const GridPosition& goal, std::vector<GridPosition>& path) {
+            return findPath(start, goal, path, scratch);
+        }
+        bool findPath(const GridPosition& start, const GridPosition& goal, std::vector<GridPosition>& path,
+                      Scratch& scratch) const;
+
+        // Пути от нескольких начал к одной цели; пустой путь - не найден.
+        // Дальние начала разделяют одно дерево кратчайших путей от цели по
+        // графу входов вместо отдельного A* на каждое
+        void findPaths(const GridPosition& goal, const std::vector<GridPosition>& starts,
+                       std::vector<std::vector<GridPosition>>& paths, Scratch& scratch) const;
+
+        bool isWalkable(const GridPosition& pos) const;
+
+        // Длина пути по опорным точкам
+        static float pathLength(const std::vector<GridPosition>& path);
+
+        std::size_t getNodeCount() const { return nodeOwner.size(); }
+        std::size_t getGraphChunkCount() const { return graphs.size(); }
+        // Растёт при каждом изменении графа
+        std::uint64_t getVersion() const { return version; }
+
+    private:
+        static constexpr int SIZE = ChunkedTileMap::CHUNK_SIZE;
+
+        struct ChunkGraph {
+            int chunkX = 0;
+            int chunkY = 0;
+            std::uint64_t serial = 0;
+            std::uint64_t version = 0;
+            // Строки маски WALKABLE чанка на момент update()
+            std::array<std::uint32_t, SIZE> walkable{};
+            // Позиции входов вдоль границы с соседом справа / снизу
+            std::vector<std::uint8_t> rightTransitions;
+            std::vector<std::uint8_t> downTransitions;
+            // Клетки-узлы (локальный индекс в чанке), по возрастанию
+            std::vector<std::uint16_t> nodes;
+            // Расстояния между узлами внутри чанка, nodes.size()^2
+            std::vector<float> distances;
+            std::uint32_t firstNode = 0;
+            // Соседние графы: справа, слева, снизу, сверху
+            const ChunkGraph* neighbors[4] = {};
+
+            bool isWalkable(int x, int y) const { return (walkable[y] >> x) & 1u; }
+            int findNode(int cell) const;
+        };
+
+        struct NodeRef {
+            const ChunkGraph* graph;
+            std::uint16_t index;
+        };
+
+        const RegionMap* regions;
+        Settings settings;
+        Scratch scratch;
+        const ChunkedTileMap* syncedMap = nullptr;
+        std::uint64_t syncedMapVersion = 0;
+        std::uint64_t version = 0;
+
+        std::unordered_map<std::uint64_t, ChunkGraph> graphs;
+        std::vector<NodeRef> nodeOwner;
+        // Буферы update()
+        std::vector<std::pair<int, int>> changedChunks;
+        std::vector<ChunkGraph*> dirtyGraphs;
+        std::vector<float> buildDistances;
+        std::vector<HeapItem> buildHeap;
+
+        const ChunkGraph* findGraph(int chunkX, int chunkY) const;
+        ChunkGraph* findGraph(int chunkX, int chunkY);
+
+        void computeTransitions(ChunkGraph& first, bool horizontal);
+        void computeNodes(ChunkGraph& graph);
+        void linkNeighbors(ChunkGraph& graph);
+        void renumberNodes();
+
+        static void chunkDistances(const ChunkGraph& graph, int source, std::vector<float>& distances,
+                                   std::vector<HeapItem>& heap, const std::vector<std::uint16_t>* targets);
+
+        GridPosition nodePosition(std::int32_t node, const GridPosition& start, const GridPosition& goal) const;
+
+        // fn(next, cost) для соседей узла графа: входы того же чанка и вход
+        // соседнего чанка через границу
+        template<typename Func>
+        void forEachNeighbor(std::int32_t node, Func&& fn) const;
+
+        bool jumpPointSearch(int minChunkX, int minChunkY, int maxChunkX, int maxChunkY,
+                             const GridPosition& start, const GridPosition& goal,
+                             std::vector<GridPosition>& path, Scratch& scratch) const;
+        bool directSearch(const GridPosition& start, const GridPosition& goal,
+                          std::vector<GridPosition>& path, Scratch& scratch) const;
+        bool hierarchicalSearch(const GridPosition& start, const GridPosition& goal,
+                                std::vector<GridPosition>& path, Scratch& scratch) const;
+        bool buildGoalTree(const GridPosition& goal, Scratch& scratch) const;
+        bool pathFromTree(const GridPosition& start, const GridPosition& goal,
+                          std::vector<GridPosition>& path, Scratch& scratch) const;
+        // Путь по клеткам вдоль scratch.abstractPath
+        bool refine(const GridPosition& start, const GridPosition& goal,
+                    std::vector<GridPosition>& path, Scratch& scratch) const;
+    };
+}
@@ -0,0 +1,135 @@
+#include "PathRequestQueue.hpp"
+#include <algorithm>
+
+namespace game {
+
+PathRequestQueue::PathRequestQueue(const PathFinder& pathFinder, const RegionMap& regions,
+                                   engine::ThreadPool& threadPool)
+    : pathFinder(pathFinder), regions(regions), threadPool(threadPool) {
+}
+
+PathRequestQueue::~PathRequestQueue() {
+    // Задачи держат снимок сами, но ждущие future должны получить ответ;
+    // ещё не отправленные запросы не ищутся и получают пустой путь
+    collectFinished(true);
+    for (auto& [groupKey, group] : queued) {
+        for (auto& promise : group.promises) {
+            promise.set_value(PathResult());
+        }
+    }
+    for (auto& promise : unreachable) {
+        promise.set_value(PathResult());
+    }
+}
+
+PathRequestQueue::Handle PathRequestQueue::request(const GridPosition& start, const GridPosition& goal) {
+    std::uint32_t region = regions.getRegion(start);
+    if (region == RegionMap::NO_REGION || region != regions.getRegion(goal)) {
+        unreachable.emplace_back();
+        return unreachable.back().get_future().share();
+    }
+
+    Group& group = queued[GroupKey(region, goal.x, goal.y)];
+    group.goal = goal;
+    auto [it, inserted] = group.startIndex.emplace(start, group.starts.size());
+    if (!inserted) {
+        ++deduplicatedCount;
+        return group.handles[it->second];
+    }
+    group.starts.push_back(start);
+    group.promises.emplace_back();
+    group.handles.push_back(group.promises.back().get_future().share());
+    ++queuedCount;
+    return group.handles.back();
+}
+
+void PathRequestQueue::update() {
+    collectFinished(false);
+    for (auto& promise : unreachable) {
+        promise.set_value(PathResult());
+    }
+    unreachable.clear();
+    submitQueued();
+}
+
+void PathRequestQueue::flush() {
+    submitQueued();
+    collectFinished(true);
+    for (auto& promise : unreachable) {
+        promise.set_value(PathResult());
+    }
+    unreachable.clear();
+}
+
+std::size_t PathRequestQueue::getRunningCount() const {
+    std::size_t count = 0;
+    for (const Batch& batch : running) {
+        for (const Group& group : batch.groups) {
+            count += group.starts.size();
+        }
+    }
+    return count;
+}
+
+void PathRequestQueue::submitQueued() {
+    if (queued.empty()) return;
+    if (!snapshot || snapshot->getVersion() != pathFinder.getVersion()) {
+        snapshot = pathFinder.snapshot();
+    }
+
+    // Группы раскладываются по пакетам примерно поровну по числу начал, по
+    // пакету на поток - чтобы не плодить мелких задач
+    const std::size_t batchCount = std::max<std::size_t>(1, std::min(threadPool.getThreadCount(), queued.size()));
+    const std::size_t perBatch = (queuedCount + batchCount - 1) / batchCount;
+    std::vector<Batch> batches(1);
+    std::size_t batchSize = 0;
+    for (auto& [groupKey, group] : queued) {
+        if (batchSize >= perBatch && batches.size() < batchCount) {
+            batches.emplace_back();
+            batchSize = 0;
+        }
+        batchSize += group.starts.size();
+        batches.back().groups.push_back(std::move(group));
+    }
+    queued.clear();
+    queuedCount = 0;
+
+    for (Batch& batch : batches) {
+        auto work = std::make_shared<std::vector<std::pair<GridPosition, std::vector<GridPosition>>>>();
+        for (const Group& group : batch.groups) {
+            work->emplace_back(group.goal, group.starts);
+        }
+        std::shared_ptr<const PathFinder> pathFinderSnapshot = snapshot;
+        batch.result = threadPool.submit([pathFinderSnapshot, work]() {
+            thread_local PathFinder::Scratch scratch;
+            BatchPaths paths(work->size());
+            for (std::size_t i = 0; i < work->size(); ++i) {
+                pathFinderSnapshot->findPaths((*work)[i].first, (*work)[i].second, paths[i], scratch);
+            }
+            return paths;
+        });
+        running.push_back(std::move(batch));
+    }
+}
+
+void PathRequestQueue::collectFinished(bool wait) {
+    for (auto it = running.begin(); it != running.end();) {
+        if (!wait && !engine::isReady(it->result)) {
+            ++it;
+            continue;
+        }
+        BatchPaths paths = it->result.get();
+        for (std::size_t g = 0; g < it->groups.size(); ++g) {
+            Group& group = it->groups[g];
+            for (std::size_t i = 0; i < group.promises.size(); ++i) {
+                PathResult result;
+                result.path = std::move(paths[g][i]);
+                result.found = !result.path.empty();
+                group.promises[i].set_value(std::move(result));
+            }
+        }
+        it = running.erase(it);
+    }
+}
+
+} // namespace game
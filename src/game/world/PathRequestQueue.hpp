@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "PathFinder.hpp"
+#include "RegionMap.hpp"
+#include "../../engine/core/ThreadPool.hpp"
+
+namespace game {
+    struct PathResult {
+        bool found = false;
+        std::vector<GridPosition> path;
+    };
+
+    // Асинхронные запросы пути: request() сразу возвращает future, а поиск
+    // идёт в пуле потоков по снимку графа PathFinder, так что кадр не ждёт.
+    //
+    // Запросы за кадр группируются по (область начала, цель): группа решается
+    // одной задачей через PathFinder::findPaths() - дальние начала делят одно
+    // дерево путей от цели, одинаковые запросы получают один и тот же future.
+    // Недостижимые по RegionMap отсекаются сразу, без поиска.
+    //
+    // Результаты выдаются только в update() - это точка синхронизации на
+    // главном потоке; там же накопленные запросы уходят в пул.
+    class PathRequestQueue {
+    public:
+        using Handle = std::shared_future<PathResult>;
+
+        PathRequestQueue(const PathFinder& pathFinder, const RegionMap& regions, engine::ThreadPool& threadPool);
+        ~PathRequestQueue();
+
+        PathRequestQueue(const PathRequestQueue&) = delete;
+        PathRequestQueue& operator=(const PathRequestQueue&) = delete;
+
+        // Главный поток; результат станет готов в одном из следующих update()
+        Handle request(const GridPosition& start, const GridPosition& goal);
+
+        // Раз в кадр после PathFinder::update(): выдаёт готовые результаты и
+        // отправляет накопленные запросы
+        void update();
+
+        // Отправляет всё накопленное и дожидается результатов
+        void flush();
+
+        std::size_t getQueuedCount() const { return queuedCount; }
+        std::size_t getRunningCount() const;
+        // Запросов, совпавших с уже стоящими в очереди
+        std::size_t getDeduplicatedCount() const { return deduplicatedCount; }
+
+    private:
+        struct Group {
+            GridPosition goal;
+            std::vector<GridPosition> starts;
+            std::vector<std::promise<PathResult>> promises;
+            std::vector<Handle> handles;
+            std::unordered_map<GridPosition, std::size_t> startIndex;
+        };
+
+        // Пути на каждое начало каждой группы пакета
+        using BatchPaths = std::vector<std::vector<std::vector<GridPosition>>>;
+
+        struct Batch {
+            std::vector<Group> groups;
+            std::future<BatchPaths> result;
+        };
+
+        using GroupKey = std::tuple<std::uint32_t, int, int>;
+
+        const PathFinder& pathFinder;
+        const RegionMap& regions;
+        engine::ThreadPool& threadPool;
+
+        std::map<GroupKey, Group> queued;
+        std::size_t queuedCount = 0;
+        std::vector<std::promise<PathResult>> unreachable;
+        std::vector<Batch> running;
+        std::shared_ptr<const PathFinder> snapshot;
+        std::size_t deduplicatedCount = 0;
+
+        void submitQueued();
+        void collectFinished(bool wait);
+    };
+}
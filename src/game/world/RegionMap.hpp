@@ -0,0 +1,264 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ChunkedTileMap.hpp"
+
+namespace game {
+    // Связные (по 4 соседям) области проходимых клеток загруженной части карты.
+    //
+    // Каждый чанк размечается отдельно: проходимые отрезки строк берутся прямо
+    // из битовой маски WALKABLE и склеиваются в компоненты чанка. Компоненты
+    // соседних чанков связываются по общим границам, а union-find над
+    // компонентами (не клетками) даёт глобальные области. После правки
+    // заново размечаются только изменившиеся чанки; объединение пересобирается
+    // по компонентам - это сотни узлов, а не миллион клеток.
+    //
+    // getRegion()/canReach() - поиск чанка в хэше и два чтения массивов.
+    // Незагруженные чанки считаются непроходимыми.
+    class RegionMap {
+    public:
+        static constexpr std::uint32_t NO_REGION = 0;
+
+        // Вызывается после изменений карты (раз в кадр): размечает новые и
+        // изменённые чанки, забывает выгруженные
+        void update(const ChunkedTileMap& map) {
+            bool changed = false;
+            if (syncedMap != &map) {
+                chunks.clear();
+                syncedMap = &map;
+                syncedMapVersion = map.getVersion();
+                changed = true;
+            } else if (syncedMapVersion != map.getVersion()) {
+                for (auto it = chunks.begin(); it != chunks.end();) {
+                    const TileChunk* chunk = map.findChunk(it->second.chunkX, it->second.chunkY);
+                    if (!chunk || chunk->serial != it->second.serial) {
+                        it = chunks.erase(it);
+                        changed = true;
+                    } else {
+                        ++it;
+                    }
+                }
+                syncedMapVersion = map.getVersion();
+            }
+
+            relabeled.clear();
+            map.forEachChunk([&](const TileChunk& chunk) {
+                ChunkLabels& labels = chunks[ChunkedTileMap::chunkKey(chunk.chunkX, chunk.chunkY)];
+                if (labels.serial != chunk.serial || labels.version != chunk.cells.getVersion()) {
+                    labelChunk(labels, chunk);
+                    relabeled.push_back(&labels);
+                }
+            });
+            for (ChunkLabels* labels : relabeled) {
+                linkNeighbors(*labels);
+                changed = true;
+            }
+            if (changed) {
+                rebuildRegions();
+            }
+        }
+
+        // NO_REGION для непроходимой клетки или незагруженного чанка
+        std::uint32_t getRegion(const GridPosition& pos) const {
+            auto coord = ChunkedTileMap::chunkOf(pos);
+            auto it = chunks.find(ChunkedTileMap::chunkKey(coord.x, coord.y));
+            if (it == chunks.end()) return NO_REGION;
+            const ChunkLabels& labels = it->second;
+            std::size_t index = static_cast<std::size_t>(pos.y & ChunkedTileMap::CHUNK_MASK) * ChunkedTileMap::CHUNK_SIZE +
+                                (pos.x & ChunkedTileMap::CHUNK_MASK);
+            std::uint16_t label = labels.cells[index];
+            return label ? regionOfNode[labels.firstNode + label - 1] : NO_REGION;
+        }
+
+        bool canReach(const GridPosition& from, const GridPosition& to) const {
+            std::uint32_t region = getRegion(from);
+            return region != NO_REGION && region == getRegion(to);
+        }
+
+        std::size_t getRegionCount() const { return regionCount; }
+
+        // Растёт при каждом пересчёте областей
+        std::uint64_t getVersion() const { return version; }
+
+    private:
+        static constexpr int SIZE = ChunkedTileMap::CHUNK_SIZE;
+
+        using Link = std::pair<std::uint16_t, std::uint16_t>;
+
+        struct ChunkLabels {
+            int chunkX = 0;
+            int chunkY = 0;
+            std::uint64_t serial = 0;
+            std::uint64_t version = 0;
+            // Номер компоненты чанка на клетку, 1..componentCount; 0 - непроходимо
+            std::array<std::uint16_t, SIZE * SIZE> cells{};
+            std::uint16_t componentCount = 0;
+            // Узел union-find первой компоненты
+            std::uint32_t firstNode = 0;
+            // Пары (компонента здесь, компонента соседа справа / снизу)
+            std::vector<Link> rightLinks;
+            std::vector<Link> downLinks;
+        };
+
+        std::unordered_map<std::uint64_t, ChunkLabels> chunks;
+        std::vector<ChunkLabels*> relabeled;
+        std::vector<std::uint32_t> regionOfNode;
+        std::vector<std::uint32_t> parent;
+        std::size_t regionCount = 0;
+        std::uint64_t version = 0;
+        const ChunkedTileMap* syncedMap = nullptr;
+        std::uint64_t syncedMapVersion = 0;
+
+        const ChunkLabels* findLabels(int chunkX, int chunkY) const {
+            auto it = chunks.find(ChunkedTileMap::chunkKey(chunkX, chunkY));
+            return it != chunks.end() ? &it->second : nullptr;
+        }
+
+        ChunkLabels* findLabels(int chunkX, int chunkY) {
+            auto it = chunks.find(ChunkedTileMap::chunkKey(chunkX, chunkY));
+            return it != chunks.end() ? &it->second : nullptr;
+        }
+
+        static std::uint32_t findRoot(std::vector<std::uint32_t>& parents, std::uint32_t node) {
+            while (parents[node] != node) {
+                parents[node] = parents[parents[node]];
+                node = parents[node];
+            }
+            return node;
+        }
+
+        static void unite(std::vector<std::uint32_t>& parents, std::uint32_t a, std::uint32_t b) {
+            a = findRoot(parents, a);
+            b = findRoot(parents, b);
+            if (a != b) {
+                parents[std::max(a, b)] = std::min(a, b);
+            }
+        }
+
+        // Отрезки проходимых клеток по строкам маски, склеенные с
+        // пересекающимися отрезками предыдущей строки
+        static void labelChunk(ChunkLabels& labels, const TileChunk& chunk) {
+            struct Run {
+                int y;
+                int x0;
+                int x1;  // включительно
+            };
+            std::vector<Run> runs;
+            std::vector<std::uint32_t> runParent;
+            std::size_t previousBegin = 0, previousEnd = 0;
+
+            for (int y = 0; y < SIZE; ++y) {
+                std::uint32_t word = chunk.bits.row(TileBitmaps::WALKABLE, y);
+                std::size_t rowBegin = runs.size();
+                while (word) {
+                    int x0 = TileBitmaps::lowestBit(word);
+                    std::uint32_t rest = ~word & ~((1u << x0) - 1);
+                    int x1 = rest ? TileBitmaps::lowestBit(rest) - 1 : SIZE - 1;
+                    word &= rest ? ~((1u << (x1 + 1)) - 1) : 0;
+
+                    std::uint32_t run = static_cast<std::uint32_t>(runs.size());
+                    runs.push_back({y, x0, x1});
+                    runParent.push_back(run);
+                    for (std::size_t above = previousBegin; above < previousEnd; ++above) {
+                        if (runs[above].x0 <= x1 && runs[above].x1 >= x0) {
+                            unite(runParent, static_cast<std::uint32_t>(above), run);
+                        }
+                    }
+                }
+                previousBegin = rowBegin;
+                previousEnd = runs.size();
+            }
+
+            labels.chunkX = chunk.chunkX;
+            labels.chunkY = chunk.chunkY;
+            labels.serial = chunk.serial;
+            labels.version = chunk.cells.getVersion();
+            labels.cells.fill(0);
+            labels.componentCount = 0;
+
+            std::vector<std::uint16_t> labelOfRoot(runs.size(), 0);
+            for (std::size_t i = 0; i < runs.size(); ++i) {
+                std::uint32_t root = findRoot(runParent, static_cast<std::uint32_t>(i));
+                if (!labelOfRoot[root]) {
+                    labelOfRoot[root] = ++labels.componentCount;
+                }
+                std::uint16_t label = labelOfRoot[root];
+                std::uint16_t* row = &labels.cells[static_cast<std::size_t>(runs[i].y) * SIZE];
+                std::fill(row + runs[i].x0, row + runs[i].x1 + 1, label);
+            }
+        }
+
+        // Связи по границе a (слева/сверху) и b; соседние одинаковые пары
+        // схлопываются, так что на границу обычно приходится несколько связей
+        static void linkEdge(const ChunkLabels& a, const ChunkLabels& b, bool horizontal, std::vector<Link>& links) {
+            links.clear();
+            for (int i = 0; i < SIZE; ++i) {
+                std::size_t from = horizontal ? static_cast<std::size_t>(i) * SIZE + (SIZE - 1)
+                                              : static_cast<std::size_t>(SIZE - 1) * SIZE + i;
+                std::size_t to = horizontal ? static_cast<std::size_t>(i) * SIZE
+                                            : static_cast<std::size_t>(i);
+                Link link(a.cells[from], b.cells[to]);
+                if (link.first && link.second && (links.empty() || links.back() != link)) {
+                    links.push_back(link);
+                }
+            }
+        }
+
+        void linkNeighbors(ChunkLabels& labels) {
+            int chunkX = labels.chunkX, chunkY = labels.chunkY;
+            if (const ChunkLabels* right = findLabels(chunkX + 1, chunkY)) {
+                linkEdge(labels, *right, true, labels.rightLinks);
+            }
+            if (const ChunkLabels* down = findLabels(chunkX, chunkY + 1)) {
+                linkEdge(labels, *down, false, labels.downLinks);
+            }
+            if (ChunkLabels* left = findLabels(chunkX - 1, chunkY)) {
+                linkEdge(*left, labels, true, left->rightLinks);
+            }
+            if (ChunkLabels* up = findLabels(chunkX, chunkY - 1)) {
+                linkEdge(*up, labels, false, up->downLinks);
+            }
+        }
+
+        void rebuildRegions() {
+            std::uint32_t nodeCount = 0;
+            for (auto& [chunkKey, labels] : chunks) {
+                labels.firstNode = nodeCount;
+                nodeCount += labels.componentCount;
+            }
+            parent.resize(nodeCount);
+            std::iota(parent.begin(), parent.end(), 0u);
+
+            for (const auto& [chunkKey, labels] : chunks) {
+                const ChunkLabels* right = findLabels(labels.chunkX + 1, labels.chunkY);
+                const ChunkLabels* down = findLabels(labels.chunkX, labels.chunkY + 1);
+                // Связи с выгруженным соседом устарели - пропускаем
+                if (right) {
+                    for (const Link& link : labels.rightLinks) {
+                        unite(parent, labels.firstNode + link.first - 1, right->firstNode + link.second - 1);
+                    }
+                }
+                if (down) {
+                    for (const Link& link : labels.downLinks) {
+                        unite(parent, labels.firstNode + link.first - 1, down->firstNode + link.second - 1);
+                    }
+                }
+            }
+
+            regionOfNode.assign(nodeCount, NO_REGION);
+            regionCount = 0;
+            for (std::uint32_t node = 0; node < nodeCount; ++node) {
+                std::uint32_t root = findRoot(parent, node);
+                if (regionOfNode[root] == NO_REGION) {
+                    regionOfNode[root] = static_cast<std::uint32_t>(++regionCount);
+                }
+                regionOfNode[node] = regionOfNode[root];
+            }
+            ++version;
+        }
+    };
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "TileLayer.hpp"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace game {
+    // Битовые маски чанка 32x32: по одной на каждый TileType, плюс проходимость
+    // и пригодность для строительства. Строка чанка - одно 32-битное слово,
+    // поэтому подсчёт в прямоугольнике - это AND с маской столбцов и popcount
+    // по строкам, а поиск клеток - ctz по словам. Число установленных бит в
+    // каждой маске хранится отдельно: чанк, целиком попавший в запрос,
+    // учитывается за O(1).
+    class TileBitmaps {
+    public:
+        static constexpr int SIZE = 32;
+        static constexpr std::size_t WALKABLE = TILE_TYPE_COUNT;
+        static constexpr std::size_t BUILDABLE = TILE_TYPE_COUNT + 1;
+        static constexpr std::size_t LAYER_COUNT = TILE_TYPE_COUNT + 2;
+
+        static std::size_t layerOf(TileType type) { return static_cast<std::size_t>(type); }
+
+        static int bitCount(std::uint32_t word) {
+#if defined(_MSC_VER)
+            return static_cast<int>(__popcnt(word));
+#else
+            return __builtin_popcount(word);
+#endif
+        }
+
+        // Номер младшего установленного бита; word != 0
+        static int lowestBit(std::uint32_t word) {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, word);
+            return static_cast<int>(index);
+#else
+            return __builtin_ctz(word);
+#endif
+        }
+
+        // Биты столбцов x0..x1 включительно
+        static std::uint32_t columnMask(int x0, int x1) {
+            std::uint32_t upper = x1 >= SIZE - 1 ? ~0u : (1u << (x1 + 1)) - 1;
+            return upper & ~((1u << x0) - 1);
+        }
+
+        // Полный пересчёт по клеткам (cells - слой чанка SIZE x SIZE)
+        void rebuild(const TileLayer& cells) {
+            for (auto& layer : rows) {
+                layer.fill(0);
+            }
+            const TileType* types = cells.typeData();
+            const std::uint8_t* walkable = cells.walkableData();
+            const std::uint8_t* buildable = cells.buildableData();
+            for (int y = 0; y < SIZE; ++y) {
+                for (int x = 0; x < SIZE; ++x) {
+                    std::size_t index = static_cast<std::size_t>(y) * SIZE + x;
+                    std::uint32_t bit = 1u << x;
+                    rows[layerOf(types[index])][y] |= bit;
+                    if (walkable[index]) rows[WALKABLE][y] |= bit;
+                    if (buildable[index]) rows[BUILDABLE][y] |= bit;
+                }
+            }
+            for (std::size_t layer = 0; layer < LAYER_COUNT; ++layer) {
+                counts[layer] = 0;
+                for (std::uint32_t word : rows[layer]) {
+                    counts[layer] += bitCount(word);
+                }
+            }
+        }
+
+        // После записи клетки index в обход rebuild()
+        void updateCell(const TileLayer& cells, std::size_t index) {
+            int x = static_cast<int>(index % SIZE), y = static_cast<int>(index / SIZE);
+            for (std::size_t type = 0; type < TILE_TYPE_COUNT; ++type) {
+                setBit(type, x, y, false);
+            }
+            setBit(layerOf(cells.getType(index)), x, y, true);
+            setBit(WALKABLE, x, y, cells.isWalkable(index));
+            setBit(BUILDABLE, x, y, cells.isBuildable(index));
+        }
+
+        std::uint32_t row(std::size_t layer, int y) const { return rows[layer][y]; }
+        int count(std::size_t layer) const { return counts[layer]; }
+
+    private:
+        std::array<std::array<std::uint32_t, SIZE>, LAYER_COUNT> rows{};
+        std::array<int, LAYER_COUNT> counts{};
+
+        void setBit(std::size_t layer, int x, int y, bool value) {
+            std::uint32_t bit = 1u << x;
+            bool current = (rows[layer][y] & bit) != 0;
+            if (current == value) return;
+            rows[layer][y] ^= bit;
+            counts[layer] += value ? 1 : -1;
+        }
+    };
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "../Tile.hpp"
+#include "BiomeType.hpp"
+#include "TileProperties.hpp"
+
+namespace game {
+    // Прямоугольник тайлов в виде SoA: каждое поле хранится отдельным плоским
+    // массивом, индекс клетки = (y - originY) * width + (x - originX).
+    // Вместо сущности с четырьмя компонентами на клетку - около 20 байт, а
+    // проходы по клеткам (генерация, замена типов, подсчёты) идут по
+    // непрерывным массивам и векторизуются компилятором. Служит хранилищем
+    // одного чанка ChunkedTileMap.
+    //
+    // Любая запись через сеттеры увеличивает версию слоя; после записи
+    // напрямую в *Data() нужно вызвать markChanged().
+    class TileLayer {
+    public:
+        TileLayer() = default;
+
+        TileLayer(int width, int height, int originX = 0, int originY = 0) {
+            resize(width, height, originX, originY);
+        }
+
+        // Все клетки становятся пустыми (TileType::NONE)
+        void resize(int width, int height, int originX = 0, int originY = 0) {
+            this->width = width > 0 ? width : 0;
+            this->height = height > 0 ? height : 0;
+            this->originX = originX;
+            this->originY = originY;
+
+            std::size_t count = getCellCount();
+            types.assign(count, TileType::NONE);
+            walkable.assign(count, 0);
+            buildable.assign(count, 0);
+            biomes.assign(count, BiomeType::TEMPERATE);
+            elevation.assign(count, 0.0f);
+            fertility.assign(count, 0.0f);
+            temperature.assign(count, 0.0f);
+            humidity.assign(count, 0.0f);
+            markChanged();
+        }
+
+        void clear() { resize(0, 0); }
+
+        int getWidth() const { return width; }
+        int getHeight() const { return height; }
+        int getOriginX() const { return originX; }
+        int getOriginY() const { return originY; }
+        std::size_t getCellCount() const { return static_cast<std::size_t>(width) * height; }
+        bool empty() const { return getCellCount() == 0; }
+
+        bool contains(const GridPosition& pos) const {
+            return pos.x >= originX && pos.y >= originY &&
+                   pos.x < originX + width && pos.y < originY + height;
+        }
+
+        // Без проверки границ - вызывающий проверяет contains()
+        std::size_t cellIndex(const GridPosition& pos) const {
+            return static_cast<std::size_t>(pos.y - originY) * width + (pos.x - originX);
+        }
+
+        GridPosition cellPosition(std::size_t index) const {
+            return GridPosition(originX + static_cast<int>(index % width),
+                                originY + static_cast<int>(index / width));
+        }
+
+        // Заполнение клетки из описания типа
+        void setTile(std::size_t index, const TileData& data) {
+            types[index] = data.type;
+            walkable[index] = data.walkable ? 1 : 0;
+            buildable[index] = data.buildable ? 1 : 0;
+            elevation[index] = data.elevation;
+            fertility[index] = data.fertility;
+            temperature[index] = data.temperature;
+            humidity[index] = data.humidity;
+            markChanged();
+        }
+
+        void setProperties(std::size_t index, const TileProperties& props) {
+            walkable[index] = props.walkable ? 1 : 0;
+            buildable[index] = props.buildable ? 1 : 0;
+            elevation[index] = props.elevation;
+            fertility[index] = props.fertility;
+            temperature[index] = props.temperature;
+            humidity[index] = props.humidity;
+            markChanged();
+        }
+
+        TileProperties getProperties(std::size_t index) const {
+            return TileProperties(walkable[index] != 0, buildable[index] != 0, elevation[index],
+                                  fertility[index], temperature[index], humidity[index]);
+        }
+
+        TileType getType(std::size_t index) const { return types[index]; }
+        void setType(std::size_t index, TileType type) { types[index] = type; markChanged(); }
+
+        bool isWalkable(std::size_t index) const { return walkable[index] != 0; }
+        void setWalkable(std::size_t index, bool value) { walkable[index] = value ? 1 : 0; markChanged(); }
+
+        bool isBuildable(std::size_t index) const { return buildable[index] != 0; }
+        BiomeType getBiome(std::size_t index) const { return biomes[index]; }
+        void setBiome(std::size_t index, BiomeType biome) { biomes[index] = biome; markChanged(); }
+
+        // Сырые массивы для проходов по всей карте
+        TileType* typeData() { return types.data(); }
+        const TileType* typeData() const { return types.data(); }
+        std::uint8_t* walkableData() { return walkable.data(); }
+        const std::uint8_t* walkableData() const { return walkable.data(); }
+        std::uint8_t* buildableData() { return buildable.data(); }
+        const std::uint8_t* buildableData() const { return buildable.data(); }
+        BiomeType* biomeData() { return biomes.data(); }
+        const BiomeType* biomeData() const { return biomes.data(); }
+        float* elevationData() { return elevation.data(); }
+        const float* elevationData() const { return elevation.data(); }
+        float* fertilityData() { return fertility.data(); }
+        const float* fertilityData() const { return fertility.data(); }
+        float* temperatureData() { return temperature.data(); }
+        const float* temperatureData() const { return temperature.data(); }
+        float* humidityData() { return humidity.data(); }
+        const float* humidityData() const { return humidity.data(); }
+
+        // Растёт при любом изменении - по ней кэши (рендер и т.п.) понимают,
+        // что их нужно обновить
+        std::uint64_t getVersion() const { return version; }
+        void markChanged() { ++version; }
+
+    private:
+        int width = 0;
+        int height = 0;
+        int originX = 0;
+        int originY = 0;
+
+        std::vector<TileType> types;
+        std::vector<std::uint8_t> walkable;
+        std::vector<std::uint8_t> buildable;
+        std::vector<BiomeType> biomes;
+        std::vector<float> elevation;
+        std::vector<float> fertility;
+        std::vector<float> temperature;
+        std::vector<float> humidity;
+
+        std::uint64_t version = 0;
+    };
+}
@@ -1,5 +1,5 @@
 #include "WorldMap.hpp"
-#include <FastNoiseLite.h>
+#include "../../engine/core/BatchNoise.hpp"
 #include <algorithm>
 #include <ctime>
 
@@ -17,29 +17,15 @@ void WorldMap::generate(uint32_t seed) {
 }
 
 void WorldMap::generateElevation() {
-   FastNoiseLite noise;
-   noise.SetSeed(rng());
-   noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-   
-   // Настраиваем параметры шума для elevation
-   noise.SetFrequency(0.02f);
-   
-   // Генерируем карту высот с несколькими октавами
+   // Несколько слоев шума: частота каждого x2, амплитуда x0.5
+   engine::BatchNoise noise(static_cast<int>(rng()), 0.02f, 4);
+   std::vector<float> row(width);
+
    for (int y = 0; y < height; ++y) {
+       noise.fillRow(0, y, width, row.data());
        for (int x = 0; x < width; ++x) {
-           float e = 0.0f;
-           float amp = 1.0f;
-           float freq = 1.0f;
-           
-           // Добавляем несколько слоев шума
-           for (int i = 0; i < 4; i++) {
-               e += noise.GetNoise(x * freq, y * freq) * amp;
-               amp *= 0.5f;
-               freq *= 2.0f;
-           }
-           
            // Нормализуем значение в диапазон [-1, 1]
-           e = std::clamp(e, -1.0f, 1.0f);
+           float e = std::clamp(row[x], -1.0f, 1.0f);
            
            WorldTile& tile = getTile(x, y);
            tile.elevation = e;
@@ -49,19 +35,18 @@ void WorldMap::generateElevation() {
 }
 
 void WorldMap::generateTemperature() {
-   FastNoiseLite noise;
-   noise.SetSeed(rng());
-   noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-   noise.SetFrequency(0.01f);
+   engine::BatchNoise noise(static_cast<int>(rng()), 0.01f);
+   std::vector<float> row(width);
 
    for (int y = 0; y < height; ++y) {
+       noise.fillRow(0, y, width, row.data());
        for (int x = 0; x < width; ++x) {
            // Базовая температура зависит от широты (y координаты)
            float latitudeTemp = 1.0f - std::abs(float(y - height/2) / (height/2));
            latitudeTemp = latitudeTemp * 40.0f - 10.0f; // преобразуем в температуру (-10 до 30)
            
            // Добавляем случайные вариации
-           float variation = noise.GetNoise(x * 1.0f, y * 1.0f) * 10.0f;
+           float variation = row[x] * 10.0f;
            
            // Учитываем высоту (понижение температуры с высотой)
            float elevationEffect = getTile(x, y).elevation * -10.0f;
@@ -77,14 +62,13 @@ void WorldMap::generateTemperature() {
 }
 
 void WorldMap::generateRainfall() {
-   FastNoiseLite noise;
-   noise.SetSeed(rng());
-   noise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-   noise.SetFrequency(0.015f);
+   engine::BatchNoise noise(static_cast<int>(rng()), 0.015f);
+   std::vector<float> row(width);
 
    for (int y = 0; y < height; ++y) {
+       noise.fillRow(0, y, width, row.data());
        for (int x = 0; x < width; ++x) {
-           float r = noise.GetNoise(x * 1.0f, y * 1.0f);
+           float r = row[x];
            // Преобразуем в диапазон [0, 1]
            r = (r + 1.0f) * 0.5f;
            
@@ -1,7 +1,9 @@
 #include "engine/Window.hpp"
 #include "engine/core/Renderer.hpp"
 #include "engine/core/ResourceCache.hpp"
+#include "engine/core/ThreadPool.hpp"
 #include "engine/ecs/World.hpp"
+#include "engine/ecs/SystemScheduler.hpp"
 #include "engine/ecs/systems/RenderSystem.hpp"
 #include "engine/ecs/systems/TileSystem.hpp"
 #include "engine/ecs/systems/SelectionSystem.hpp"
@@ -11,12 +13,21 @@
 
 #include "game/world/WorldMap.hpp"
 #include "game/world/LocalMapGenerator.hpp"
+#include "game/world/MapRegenerator.hpp"
 #include "game/world/TileRegistry.hpp"
+#include "game/world/ChunkedTileMap.hpp"
+#include "game/world/ChunkStreamer.hpp"
+#include "game/world/RegionMap.hpp"
+#include "game/world/PathFinder.hpp"
+#include "game/world/PathRequestQueue.hpp"
+#include "game/world/FlowField.hpp"
 #include "game/world/BiomeType.hpp"
 #include "game/Tile.hpp"
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <climits>
 #include <iostream>
 #include <ctime>
 
@@ -64,6 +75,7 @@ int main()
 
         // ECS системы
         World world;
+        ChunkedTileMap tileMap;
         RenderSystem renderSystem(*renderer);
         TileSystem tileSystem;
         SelectionSystem selectionSystem;
@@ -72,14 +84,61 @@ int main()
         SerializationSystem serializationSystem;
         TileRegistry tileRegistry(*resourceCache);
 
+        // Планировщик систем: системы без конфликтов по компонентам выполняются параллельно
+        ThreadPool threadPool;
+        SystemScheduler scheduler(threadPool);
+        // Подгрузка чанков вокруг камеры в том же пуле потоков
+        ChunkStreamer chunkStreamer(tileMap, threadPool);
+        // Связные проходимые области для проверок достижимости
+        RegionMap regionMap;
+        // Поиск пути: JPS вблизи, граф входов чанков (HPA*) для дальних целей
+        PathFinder pathFinder(&regionMap);
+        // Запросы пути решаются в пуле, результаты приходят в pathRequests.update()
+        PathRequestQueue pathRequests(pathFinder, regionMap, threadPool);
+        PathRequestQueue::Handle selectionPathRequest;
+        GridPosition selectionPathFrom, selectionPathTo;
+        PathResult selectionPath;
+        // Поля потока для толп, идущих к одним целям; считаются в пуле
+        FlowFieldCache flowFields(threadPool);
+        GridPosition hoveredPos;
+        // Видимая область в клетках (углы включительно)
+        GridPosition viewMin, viewMax;
+
+        scheduler.addSystem("Selection", SelectionSystem::getAccess(), [&](World&) {
+            selectionSystem.updateSelection(tileMap, hoveredPos);
+        });
+        scheduler.addSystem("Render", RenderSystem::getAccess(), [&](World& w) {
+            renderSystem.render(w, tileMap, selectionSystem.getHighlighted(), viewMin, viewMax);
+        });
+
+        // Редактирование тайлов: тип кисти и область последней правки
+        TileType paintType = TileType::GRASS;
+        TileRegion lastEdit;
+        editSystem.addEditListener([&](const TileRegion& region) {
+            lastEdit = region;
+        });
+        // Отмена правки может затронуть уже выгруженные чанки
+        auto loadChunk = [&](int chunkX, int chunkY) {
+            return chunkStreamer.acquireChunk(chunkX, chunkY);
+        };
+
         // Создаем генераторы карт
         WorldMap worldMap(50, 50); // Создаем глобальную карту 500x500
-        LocalMapGenerator mapGenerator(*resourceCache, tileRegistry);
+        auto mapGenerator = std::make_unique<LocalMapGenerator>(*resourceCache, tileRegistry);
+        // Перегенерация в фоне; до готовности на экране остаётся прежняя карта
+        MapRegenerator mapRegenerator(*resourceCache, tileRegistry, threadPool);
+        // Загрузка сохранения: идущая генерация иначе подменила бы загруженную карту
+        auto loadSavedMap = [&]() {
+            mapRegenerator.cancel();
+            chunkStreamer.reset(nullptr);
+            editSystem.getHistory().clear();
+            return serializationSystem.loadMap(tileMap, "world.bin", *resourceCache, tileSystem);
+        };
 
         // Параметры генерации локальной карты
         LocalMapGenerator::GenerationParams genParams;
-        genParams.width = 50;
-        genParams.height = 50;
+        genParams.width = 1024;
+        genParams.height = 1024;
         genParams.detailLevel = 1.0f;
         genParams.roughness = 1.0f;
         genParams.seed = static_cast<uint32_t>(std::time(nullptr));
@@ -88,10 +147,12 @@ int main()
         worldMap.generate(genParams.seed);
 
         // Берем центральный тайл глобальной карты для генерации локальной
-        const auto &globalTile = worldMap.getTile(25, 25);
+        WorldMap::WorldTile globalTile = worldMap.getTile(25, 25);
 
-        // Генерируем локальную карту на основе глобального тайла
-        mapGenerator.generateMap(world, tileSystem, globalTile, genParams);
+        // Локальная карта на основе глобального тайла: здесь только настройка,
+        // сами чанки генерируются по мере приближения к ним камеры
+        chunkStreamer.reset(mapGenerator.get());
+        mapGenerator->beginMap(tileMap, globalTile, genParams);
 
         Camera camera(1.0f, aspect);
         window.setCamera(&camera);
@@ -143,8 +204,90 @@ int main()
             rayStart /= rayStart.w;
             glm::vec2 worldPos(rayStart.x, rayStart.y);
 
-            GridPosition hoveredPos = TileSystem::worldToGrid(worldPos);
-            selectionSystem.updateSelection(world, hoveredPos);
+            hoveredPos = TileSystem::worldToGrid(worldPos);
+
+            // Видимая область - по четырём углам экрана
+            viewMin = GridPosition(INT_MAX, INT_MAX);
+            viewMax = GridPosition(INT_MIN, INT_MIN);
+            for (float cornerX : {-1.0f, 1.0f})
+            {
+                for (float cornerY : {-1.0f, 1.0f})
+                {
+                    glm::vec4 corner = invMatrix * glm::vec4(cornerX, cornerY, -1.0f, 1.0f);
+                    corner /= corner.w;
+                    GridPosition cell = TileSystem::worldToGrid(glm::vec2(corner.x, corner.y));
+                    viewMin = GridPosition(std::min(viewMin.x, cell.x), std::min(viewMin.y, cell.y));
+                    viewMax = GridPosition(std::max(viewMax.x, cell.x), std::max(viewMax.y, cell.y));
+                }
+            }
+            // Готовая фоновая генерация подменяет карту целиком, между кадрами
+            if (auto regenerated = mapRegenerator.update())
+            {
+                chunkStreamer.reset(regenerated->generator.get());
+                editSystem.getHistory().clear();
+                tileMap.replaceWith(std::move(regenerated->map));
+                mapGenerator = std::move(regenerated->generator);
+                worldMap = std::move(*regenerated->worldMap);
+                globalTile = regenerated->globalTile;
+            }
+            chunkStreamer.update(viewMin, viewMax);
+
+            // Shift + ЛКМ: выделение прямоугольника перетаскиванием
+            static bool selecting = false;
+            static GridPosition selectionStart;
+            bool shiftDown = glfwGetKey(window.getGLFWwindow(), GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS;
+            bool mouseDown = glfwGetMouseButton(window.getGLFWwindow(), GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+            if (mouseDown && !ImGui::GetIO().WantCaptureMouse)
+            {
+                if (!selecting && shiftDown)
+                {
+                    selecting = true;
+                    selectionStart = hoveredPos;
+                }
+                if (selecting)
+                {
+                    selectionSystem.setSelection(CellSet::rectangle(selectionStart, hoveredPos));
+                }
+            }
+            else
+            {
+                selecting = false;
+            }
+
+            // ПКМ: рисование кистью; с нулевым радиусом - линией от прошлой клетки,
+            // чтобы не было разрывов при быстром движении мыши
+            static bool painting = false;
+            static GridPosition lastPaintPos;
+            bool rightDown = glfwGetMouseButton(window.getGLFWwindow(), GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
+            if (rightDown && !ImGui::GetIO().WantCaptureMouse)
+            {
+                // Весь мазок отменяется одним Ctrl+Z
+                if (!painting)
+                    editSystem.getHistory().beginGroup();
+                if (!painting || hoveredPos != lastPaintPos)
+                {
+                    if (selectionSystem.getBrushRadius() > 0)
+                        editSystem.paintCircle(tileMap, hoveredPos, selectionSystem.getBrushRadius(), paintType, nullptr);
+                    else
+                        editSystem.drawLine(tileMap, painting ? lastPaintPos : hoveredPos, hoveredPos, paintType, nullptr);
+                }
+                painting = true;
+                lastPaintPos = hoveredPos;
+            }
+            else if (painting)
+            {
+                editSystem.getHistory().endGroup();
+                painting = false;
+            }
+
+            // F: заливка области под курсором, ограниченная видимой частью карты
+            static bool fPressedLast = false;
+            bool fPressed = glfwGetKey(window.getGLFWwindow(), GLFW_KEY_F) == GLFW_PRESS;
+            if (fPressed && !fPressedLast && !ImGui::GetIO().WantCaptureKeyboard)
+            {
+                editSystem.floodFill(tileMap, hoveredPos, paintType, viewMin, viewMax, nullptr);
+            }
+            fPressedLast = fPressed;
 
             // Обработка контрольных клавиш (для сохранения/загрузки - Ctrl + S/L)
             static bool ctrlPressed = false;
@@ -162,13 +305,17 @@ int main()
             {
                 static bool sPressedLast = false;
                 static bool lPressedLast = false;
+                static bool zPressedLast = false;
+                static bool yPressedLast = false;
 
                 bool sPressed = glfwGetKey(window.getGLFWwindow(), GLFW_KEY_S) == GLFW_PRESS;
                 bool lPressed = glfwGetKey(window.getGLFWwindow(), GLFW_KEY_L) == GLFW_PRESS;
+                bool zPressed = glfwGetKey(window.getGLFWwindow(), GLFW_KEY_Z) == GLFW_PRESS;
+                bool yPressed = glfwGetKey(window.getGLFWwindow(), GLFW_KEY_Y) == GLFW_PRESS;
 
                 if (sPressed && !sPressedLast)
                 {
-                    if (serializationSystem.saveMap(world, "world.bin"))
+                    if (serializationSystem.saveMap(chunkStreamer, "world.bin"))
                     {
                         std::cout << "Map saved successfully" << std::endl;
                     }
@@ -176,20 +323,39 @@ int main()
 
                 if (lPressed && !lPressedLast)
                 {
-                    if (serializationSystem.loadMap(world, "world.bin", *resourceCache, tileSystem))
+                    if (loadSavedMap())
                     {
                         std::cout << "Map loaded successfully" << std::endl;
                     }
                 }
 
+                // Ctrl + Z/Y: отмена и повтор правки
+                if (zPressed && !zPressedLast)
+                {
+                    editSystem.undo(tileMap, loadChunk);
+                }
+
+                if (yPressed && !yPressedLast)
+                {
+                    editSystem.redo(tileMap, loadChunk);
+                }
+
                 sPressedLast = sPressed;
                 lPressedLast = lPressed;
+                zPressedLast = zPressed;
+                yPressedLast = yPressed;
             }
 
+            // Области пересчитываются по изменённым за кадр чанкам
+            regionMap.update(tileMap);
+            pathFinder.update(tileMap);
+            pathRequests.update();
+            flowFields.update(tileMap);
+
             // Основной рендеринг
             renderer->beginFrame();
             renderer->setViewProjection(camera.getProjectionMatrix() * camera.getViewMatrix());
-            renderSystem.render(world);
+            scheduler.run(world);
             renderer->endFrame();
 
             // UI
@@ -204,15 +370,21 @@ int main()
                 ImGui::SliderFloat("Detail Level", &genParams.detailLevel, 0.1f, 2.0f, "%.1f");
                 ImGui::SliderFloat("Roughness", &genParams.roughness, 0.1f, 2.0f, "%.1f");
 
-                if (ImGui::Button("Regenerate Map"))
+                if (mapRegenerator.isRunning())
+                {
+                    ImGui::ProgressBar(mapRegenerator.getProgress(), ImVec2(-1.0f, 0.0f), "Generating...");
+                    if (ImGui::Button("Cancel"))
+                    {
+                        mapRegenerator.cancel();
+                    }
+                }
+                else if (ImGui::Button("Regenerate Map"))
                 {
                     // Генерируем новый сид
                     genParams.seed = static_cast<uint32_t>(std::time(nullptr));
 
-                    // Пересоздаем карты
-                    worldMap.generate(genParams.seed);
-                    world = World(); // Очищаем текущий мир
-                    mapGenerator.generateMap(world, tileSystem, globalTile, genParams);
+                    // Пересоздаем карты в фоне, видимая область - сразу
+                    mapRegenerator.start(genParams, viewMin, viewMax);
                 }
 
                 ImGui::Separator();
@@ -241,51 +413,139 @@ int main()
 
                 ImGui::Separator();
 
+                ImGui::Text("Chunks:");
+                ImGui::Text("Resident: %zu", tileMap.getChunkCount());
+                ImGui::Text("Pending Jobs: %zu", chunkStreamer.getPendingCount());
+                ImGui::Text("Memory: %.1f / %.1f MB",
+                            chunkStreamer.getResidentBytes() / (1024.0 * 1024.0),
+                            chunkStreamer.getSettings().memoryBudget / (1024.0 * 1024.0));
+
+                ImGui::Separator();
+
                 ImGui::Text("Mouse & Tile:");
                 ImGui::Text("Screen Position: (%.1f, %.1f)", mousePos.x, mousePos.y);
                 ImGui::Text("World Position: (%.2f, %.2f)", worldPos.x, worldPos.y);
                 ImGui::Text("Grid Position: (%d, %d)", hoveredPos.x, hoveredPos.y);
 
-                if (const auto *selectedTile = selectionSystem.getSelectedTile())
+                // Запросы по битовым маскам чанков
+                ImGui::Text("%s in View: %zu", getTileTypeName(paintType).c_str(),
+                            tileMap.countInRect(TileBitmaps::layerOf(paintType), viewMin, viewMax));
+                GridPosition nearestWater;
+                if (tileMap.findNearest(TileBitmaps::layerOf(TileType::WATER), hoveredPos, nearestWater, 256))
+                    ImGui::Text("Nearest Water: (%d, %d)", nearestWater.x, nearestWater.y);
+                else
+                    ImGui::Text("Nearest Water: none within 256");
+                ImGui::Text("Walkable Region: %u of %zu", regionMap.getRegion(hoveredPos), regionMap.getRegionCount());
+                if (!selectionSystem.getSelection().empty())
+                {
+                    const auto &firstSpan = selectionSystem.getSelection().getSpans().front();
+                    GridPosition selectionCorner(firstSpan.x0, firstSpan.y);
+                    ImGui::Text("Reachable from Selection: %s",
+                                regionMap.canReach(selectionCorner, hoveredPos) ? "Yes" : "No");
+                    if (!selectionPathRequest.valid() || selectionPathFrom != selectionCorner || selectionPathTo != hoveredPos)
+                    {
+                        selectionPathRequest = pathRequests.request(selectionCorner, hoveredPos);
+                        selectionPathFrom = selectionCorner;
+                        selectionPathTo = hoveredPos;
+                    }
+                    // До ответа показываем прошлый путь
+                    if (engine::isReady(selectionPathRequest))
+                        selectionPath = selectionPathRequest.get();
+                    if (selectionPath.found)
+                        ImGui::Text("Path from Selection: %zu waypoints, length %.1f",
+                                    selectionPath.path.size(), PathFinder::pathLength(selectionPath.path));
+                    GridPosition flowStep;
+                    auto flowField = flowFields.request({selectionCorner});
+                    if (flowField && flowField->getDirection(hoveredPos, flowStep))
+                        ImGui::Text("Flow to Selection: cost %.1f, step (%d, %d)",
+                                    flowField->getCost(hoveredPos), flowStep.x, flowStep.y);
+                }
+
+                int brushRadius = selectionSystem.getBrushRadius();
+                if (ImGui::SliderInt("Brush Radius", &brushRadius, 0, 16))
+                {
+                    selectionSystem.setBrushRadius(brushRadius);
+                }
+                ImGui::Text("Selected Cells: %zu", selectionSystem.getSelection().size());
+                if (ImGui::Button("Clear Selection"))
+                {
+                    selectionSystem.clearSelection();
+                }
+
+                ImGui::Separator();
+
+                ImGui::Text("Tile Editing (RMB - paint, F - flood fill):");
+                if (ImGui::BeginCombo("Paint Type", getTileTypeName(paintType).c_str()))
+                {
+                    for (std::size_t type = 1; type < TILE_TYPE_COUNT; ++type)
+                    {
+                        TileType option = static_cast<TileType>(type);
+                        if (ImGui::Selectable(getTileTypeName(option).c_str(), option == paintType))
+                            paintType = option;
+                    }
+                    ImGui::EndCombo();
+                }
+                if (ImGui::Button("Fill Selection"))
+                {
+                    editSystem.fillCells(tileMap, selectionSystem.getSelection(), paintType, nullptr);
+                }
+                if (!lastEdit.empty())
+                {
+                    ImGui::Text("Last Edit: %zu cells in (%d, %d) - (%d, %d)", lastEdit.changedCells,
+                                lastEdit.min.x, lastEdit.min.y, lastEdit.max.x, lastEdit.max.y);
+                }
+
+                const TileEditHistory &history = editSystem.getHistory();
+                if (ImGui::Button("Undo (Ctrl+Z)"))
+                {
+                    editSystem.undo(tileMap, loadChunk);
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Redo (Ctrl+Y)"))
+                {
+                    editSystem.redo(tileMap, loadChunk);
+                }
+                ImGui::Text("History: %zu undo / %zu redo, %.1f / %.1f KB",
+                            history.getUndoCount(), history.getRedoCount(),
+                            history.getMemoryUsage() / 1024.0, history.getMemoryLimit() / 1024.0);
+
+                const auto *selectedTile = selectionSystem.getSelectedTile();
+                std::size_t cell = 0;
+                const TileChunk *selectedChunk = selectedTile ? tileMap.findCell(*selectedTile, cell) : nullptr;
+                if (selectedChunk)
                 {
+                    const TileLayer &cells = selectedChunk->cells;
                     ImGui::Separator();
                     ImGui::Text("Selected Tile Info:");
 
                     // Basic tile info
                     ImGui::Text("Position: (%d, %d)",
-                                selectedTile->gridPosition.x,
-                                selectedTile->gridPosition.y);
-                    
-                    // Get extended tile component
-                    auto *tileEntity = world.getEntity(selectedTile->getOwner());
-                    if (tileEntity)
-                    {
-                        auto *extTile = tileEntity->getComponent<game::ExtendedTileComponent>();
-                        if (extTile)
-                        {
-                            // Tile type and biome
-                            ImGui::Text("Type: %s", getTileTypeName(extTile->type).c_str());
-                            ImGui::Text("Biome: %s", getBiomeTypeName(extTile->biome).c_str());
-                            
-                            ImGui::Separator();
-                            
-                            // Properties
-                            ImGui::Text("Properties:");
-                            ImGui::Text("Elevation: %.2f", extTile->properties.elevation);
-                            ImGui::Text("Fertility: %.2f", extTile->properties.fertility);
-                            ImGui::Text("Temperature: %.1f°C", extTile->properties.temperature);
-                            ImGui::Text("Humidity: %.2f", extTile->properties.humidity);
-                            ImGui::Text("Walkable: %s", extTile->properties.walkable ? "Yes" : "No");
-                            ImGui::Text("Buildable: %s", extTile->properties.buildable ? "Yes" : "No");
-                            
-                            ImGui::Separator();
-                            
-                            // Modifiers
-                            ImGui::Text("Modifiers:");
-                            for (const auto& [key, value] : extTile->modifiers) {
-                                ImGui::Text("%s: %.2f", key.c_str(), value);
-                            }
-                        }
+                                selectedTile->x,
+                                selectedTile->y);
+
+                    TileProperties properties = cells.getProperties(cell);
+
+                    // Tile type and biome
+                    ImGui::Text("Type: %s", getTileTypeName(cells.getType(cell)).c_str());
+                    ImGui::Text("Biome: %s", getBiomeTypeName(cells.getBiome(cell)).c_str());
+
+                    ImGui::Separator();
+
+                    // Properties
+                    ImGui::Text("Properties:");
+                    ImGui::Text("Elevation: %.2f", properties.elevation);
+                    ImGui::Text("Fertility: %.2f", properties.fertility);
+                    ImGui::Text("Temperature: %.1f°C", properties.temperature);
+                    ImGui::Text("Humidity: %.2f", properties.humidity);
+                    ImGui::Text("Walkable: %s", properties.walkable ? "Yes" : "No");
+                    ImGui::Text("Buildable: %s", properties.buildable ? "Yes" : "No");
+
+                    ImGui::Separator();
+
+                    // Modifiers
+                    ImGui::Text("Modifiers:");
+                    for (const auto& [key, value] : tileMap.getModifiers(cells.getBiome(cell))) {
+                        ImGui::Text("%s: %.2f", key.c_str(), value);
                     }
                 }
 
@@ -296,7 +556,7 @@ int main()
 
                 if (ImGui::Button("Save Map"))
                 {
-                    if (serializationSystem.saveMap(world, "world.bin"))
+                    if (serializationSystem.saveMap(chunkStreamer, "world.bin"))
                     {
                         std::cout << "Map saved successfully" << std::endl;
                     }
@@ -310,7 +570,7 @@ int main()
 
                 if (ImGui::Button("Load Map"))
                 {
-                    if (serializationSystem.loadMap(world, "world.bin", *resourceCache, tileSystem))
+                    if (loadSavedMap())
                     {
                         std::cout << "Map loaded successfully" << std::endl;
                     }